@@ -0,0 +1,587 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <objects/bvh.hpp>
+#include <objects/camera.hpp>
+#include <objects/hittable.hpp>
+#include <objects/instance.hpp>
+#include <objects/ray_packet.hpp>
+#include <objects/sampling.hpp>
+#include <objects/transform.hpp>
+#include <objects/vec3.hpp>
+
+#include <materials/dielectric.hpp>
+#include <materials/lambertian.hpp>
+#include <materials/material_table.hpp>
+#include <materials/metal.hpp>
+
+#include <scene/scene.hpp>
+
+#include <shapes/box.hpp>
+#include <shapes/plane.hpp>
+#include <shapes/sphere.hpp>
+#include <shapes/sphere_set.hpp>
+#include <shapes/triangle_mesh.hpp>
+
+#include <randomizer.hpp>
+#include <real.hpp>
+
+// Microbenchmarks of the hot kernels and fixed-seed timings of whole scenes, printed
+// as one JSON document on stdout so runs can be diffed and plotted by scripts.
+//
+// Usage: raytracing_bench [--quick] [--threads N] [--filter S]
+//   --quick      shorter timings and smaller scene renders (for smoke tests)
+//   --threads N  highest thread count of the scene scaling runs (default: all cores)
+//   --filter S   only run benchmarks whose name contains S
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+struct options {
+  bool quick = false;
+  int max_threads = 0;
+  std::string filter;
+};
+
+// Results are folded into this so the compiler cannot drop the timed work.
+volatile double sink = 0;
+
+double seconds_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+std::string json_number(double value) {
+  std::ostringstream out;
+  out.precision(6);
+  out << value;
+  return out.str();
+}
+
+// Random rays from a box in front of the origin towards the unit cube around it,
+// so roughly half of them hit a unit-sized shape at the origin.
+std::vector<ray> make_rays(size_t count) {
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::vector<ray> rays;
+  rays.reserve(count);
+  for (size_t k = 0; k < count; ++k) {
+    point3 origin(uniform(rng), uniform(rng), 4.0 + uniform(rng));
+    point3 target(1.5 * uniform(rng), 1.5 * uniform(rng), uniform(rng));
+    rays.emplace_back(origin, target - origin);
+  }
+  return rays;
+}
+
+// Bumpy height field over [-1, 1]^2 facing +z, two triangles per cell
+std::shared_ptr<triangle_mesh> make_grid_mesh(int cells) {
+  std::vector<point3> vertices;
+  std::vector<uint32_t> indices;
+  for (int y = 0; y <= cells; ++y) {
+    for (int x = 0; x <= cells; ++x) {
+      double u = 2.0 * x / cells - 1.0;
+      double v = 2.0 * y / cells - 1.0;
+      vertices.emplace_back(u, v, 0.1 * std::sin(6.0 * u) * std::cos(6.0 * v));
+    }
+  }
+  for (int y = 0; y < cells; ++y) {
+    for (int x = 0; x < cells; ++x) {
+      uint32_t a = static_cast<uint32_t>(y * (cells + 1) + x);
+      uint32_t b = a + 1;
+      uint32_t c = a + static_cast<uint32_t>(cells + 1);
+      uint32_t d = c + 1;
+      indices.insert(indices.end(), {a, b, d, a, d, c});
+    }
+  }
+  return std::make_shared<triangle_mesh>(std::move(vertices), std::move(indices), 0);
+}
+
+class micro_suite {
+public:
+  explicit micro_suite(const options& _opts): opts(_opts) {}
+
+  // Times body(), which performs ops_per_call operations, until the minimum run
+  // time is reached; keeps the fastest of three such runs.
+  template <typename F>
+  void run(const std::string& name, size_t ops_per_call, F&& body) {
+    if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos) {
+      return;
+    }
+
+    const double min_seconds = opts.quick ? 0.02 : 0.2;
+    body();
+    double best = 1e30;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+      size_t calls = 0;
+      auto start = bench_clock::now();
+      double elapsed = 0;
+      do {
+        body();
+        ++calls;
+        elapsed = seconds_since(start);
+      } while (elapsed < min_seconds);
+      best = std::min(best, elapsed * 1e9 / (static_cast<double>(calls) * ops_per_call));
+    }
+
+    std::cerr << "  " << name << ": " << best << " ns/op" << std::endl;
+    results.push_back("    {\"name\": \"" + name + "\", \"ns_per_op\": " + json_number(best) +
+                      ", \"mops_per_s\": " + json_number(1e3 / best) + "}");
+  }
+
+  std::vector<std::string> results;
+
+private:
+  const options& opts;
+};
+
+void run_intersectors(micro_suite& suite) {
+  const std::vector<ray> rays = make_rays(4096);
+  const interval range(0.001, INF);
+
+  auto intersect_all = [&](const hittable& object) {
+    return [&]() {
+      double total = 0;
+      intersection isect;
+      for (const ray& r : rays) {
+        if (object.intersect(r, range, isect)) total += isect.t;
+      }
+      sink = sink + total;
+    };
+  };
+  auto occluded_all = [&](const hittable& object) {
+    return [&]() {
+      double total = 0;
+      for (const ray& r : rays) {
+        total += object.occluded(r, range);
+      }
+      sink = sink + total;
+    };
+  };
+  // Packing the rays is part of the timed work
+  auto hit_packet_all = [&](const hittable& object) {
+    return [&]() {
+      double total = 0;
+      intersection isects[ray_packet::size];
+      for (size_t base = 0; base < rays.size(); base += ray_packet::size) {
+        ray_packet packet;
+        for (int lane = 0; lane < ray_packet::size; ++lane) {
+          packet.set_lane(lane, rays[base + lane], range);
+        }
+        packet.finalize();
+        total += object.hit_packet(packet, packet.valid, isects);
+      }
+      sink = sink + total;
+    };
+  };
+
+  sphere ball(point3(0, 0, 0), 1.0, 0);
+  suite.run("sphere.intersect", rays.size(), intersect_all(ball));
+  suite.run("sphere.hit", rays.size(), [&]() {
+    double total = 0;
+    hit_record rec;
+    for (const ray& r : rays) {
+      if (ball.hit(r, range, rec)) total += rec.normal.x();
+    }
+    sink = sink + total;
+  });
+  suite.run("sphere.hit_packet", rays.size(), hit_packet_all(ball));
+
+  sphere_set spheres;
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  for (int k = 0; k < 64; ++k) {
+    spheres.add(point3(uniform(rng), uniform(rng), uniform(rng)), 0.15, 0);
+  }
+  suite.run("sphere_set64.intersect", rays.size(), intersect_all(spheres));
+  suite.run("sphere_set64.occluded", rays.size(), occluded_all(spheres));
+  suite.run("sphere_set64.hit_packet", rays.size(), hit_packet_all(spheres));
+
+  box cube(point3(-0.7, -0.7, -0.7), point3(0.7, 0.7, 0.7), 0);
+  suite.run("box.intersect", rays.size(), intersect_all(cube));
+  suite.run("box.hit", rays.size(), [&]() {
+    double total = 0;
+    hit_record rec;
+    for (const ray& r : rays) {
+      if (cube.hit(r, range, rec)) total += rec.normal.x();
+    }
+    sink = sink + total;
+  });
+
+  plane ground(point3(0, -0.5, 0), vec3(0, 1, 0), 0);
+  suite.run("plane.intersect", rays.size(), intersect_all(ground));
+
+  auto mesh = make_grid_mesh(128);
+  suite.run("triangle_mesh32k.intersect", rays.size(), intersect_all(*mesh));
+  suite.run("triangle_mesh32k.occluded", rays.size(), occluded_all(*mesh));
+  auto placed = instance::create(mesh, affine_transform::rotation(vec3(1, 1, 0), 30.0));
+  suite.run("instance.intersect", rays.size(), intersect_all(*placed));
+
+  hittable_list list;
+  for (int k = 0; k < 500; ++k) {
+    list.add(std::make_shared<sphere>(point3(uniform(rng), uniform(rng), uniform(rng)), 0.05, 0));
+  }
+  bvh tree(list);
+  suite.run("bvh500.intersect", rays.size(), intersect_all(tree));
+  suite.run("bvh500.occluded", rays.size(), occluded_all(tree));
+}
+
+void run_materials(micro_suite& suite) {
+  const std::vector<ray> rays = make_rays(4096);
+  std::vector<hit_record> records(rays.size());
+  sphere ball(point3(0, 0, 0), 1.0, 0);
+  for (size_t k = 0; k < rays.size(); ++k) {
+    if (!ball.hit(rays[k], interval(0.001, INF), records[k])) {
+      // Misses get a head-on hit so every record is a valid surface point.
+      records[k].p = point3(0, 0, 1);
+      records[k].set_face_normal(rays[k], vec3(0, 0, 1));
+    }
+  }
+
+  auto scatter_all = [&](const material& mat) {
+    return [&]() {
+      thread_rng().start(1, 0, 0);
+      double total = 0;
+      color attenuation;
+      ray scattered;
+      for (size_t k = 0; k < rays.size(); ++k) {
+        if (mat.scatter(rays[k], records[k], attenuation, scattered)) total += scattered.direction().x();
+      }
+      sink = sink + total;
+    };
+  };
+
+  lambertian diffuse(color(0.5, 0.5, 0.5));
+  metal mirror(color(0.8, 0.8, 0.8), 0.1);
+  dielectric glass(1.5);
+  suite.run("lambertian.scatter", rays.size(), scatter_all(diffuse));
+  suite.run("metal.scatter", rays.size(), scatter_all(mirror));
+  suite.run("dielectric.scatter", rays.size(), scatter_all(glass));
+}
+
+void run_rng(micro_suite& suite) {
+  const size_t count = 1 << 14;
+  suite.run("rng_stream.next", count, [&]() {
+    rng_stream stream;
+    stream.start(1, 2, 3);
+    double total = 0;
+    for (size_t k = 0; k < count; ++k) total += stream.next();
+    sink = sink + total;
+  });
+  suite.run("rng_stream.fill", count, [&]() {
+    rng_stream stream;
+    stream.start(1, 2, 3);
+    double values[64];
+    double total = 0;
+    for (size_t k = 0; k < count; k += 64) {
+      stream.fill(values, 64);
+      total += values[0] + values[63];
+    }
+    sink = sink + total;
+  });
+  // Two dimensions per sample, as for a pixel or lens position
+  const std::pair<const char*, sampler_kind> kinds[] = {
+    {"sampler.stratified", sampler_kind::stratified},
+    {"sampler.sobol", sampler_kind::sobol},
+    {"sampler.bluenoise", sampler_kind::blue_noise},
+  };
+  for (const auto& kind : kinds) {
+    const sampler pattern(kind.second, 64, 256);
+    suite.run(kind.first, count, [&]() {
+      double total = 0;
+      for (uint32_t k = 0; k < count; k += 2) {
+        total += pattern.value(1, k >> 6, k & 63, 0, 0) + pattern.value(1, k >> 6, k & 63, 0, 1);
+      }
+      sink = sink + total;
+    });
+  }
+  suite.run("sample_uniform_sphere", count, [&]() {
+    thread_rng().start(1, 2, 3);
+    double u[2];
+    double total = 0;
+    for (size_t k = 0; k < count; ++k) {
+      thread_rng().fill(u, 2);
+      const vec3 v = sample_uniform_sphere(u[0], u[1]).value;
+      total += v.x() + v.y() + v.z();
+    }
+    sink = sink + total;
+  });
+  suite.run("sample_cosine_hemisphere", count, [&]() {
+    thread_rng().start(1, 2, 3);
+    double u[2];
+    double total = 0;
+    for (size_t k = 0; k < count; ++k) {
+      thread_rng().fill(u, 2);
+      const vec3 v = sample_cosine_hemisphere(u[0], u[1]).value;
+      total += v.x() + v.y() + v.z();
+    }
+    sink = sink + total;
+  });
+}
+
+void run_vec3(micro_suite& suite) {
+  std::mt19937_64 rng(3);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::vector<vec3> a(4096), b(4096);
+  for (size_t k = 0; k < a.size(); ++k) {
+    a[k] = vec3(uniform(rng), uniform(rng), uniform(rng));
+    b[k] = vec3(uniform(rng), uniform(rng), uniform(rng));
+  }
+
+  suite.run("vec3.dot", a.size(), [&]() {
+    real total = 0;
+    for (size_t k = 0; k < a.size(); ++k) total += dot(a[k], b[k]);
+    sink = sink + total;
+  });
+  suite.run("vec3.cross", a.size(), [&]() {
+    vec3 total(0, 0, 0);
+    for (size_t k = 0; k < a.size(); ++k) total += cross(a[k], b[k]);
+    sink = sink + total.x();
+  });
+  suite.run("vec3.unit_vector", a.size(), [&]() {
+    vec3 total(0, 0, 0);
+    for (size_t k = 0; k < a.size(); ++k) total += unit_vector(a[k]);
+    sink = sink + total.x();
+  });
+  suite.run("vec3.madd", a.size(), [&]() {
+    vec3 total(0, 0, 0);
+    for (size_t k = 0; k < a.size(); ++k) total += a[k] * b[k] + 0.5 * a[k];
+    sink = sink + total.x();
+  });
+}
+
+// Counts the rays a render traces: every ray starts with one top-level intersect().
+class counting_world: public hittable {
+public:
+  explicit counting_world(const hittable& _inner): inner(_inner) {}
+
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override {
+    ++count;
+    return inner.intersect(r, ray_interval, isect);
+  }
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override {
+    isect.object->surface_interaction(r, isect, rec);
+  }
+  aabb bounding_box() const override {
+    return inner.bounding_box();
+  }
+
+  mutable uint64_t count = 0;
+
+private:
+  const hittable& inner;
+};
+
+struct bench_scene {
+  std::string name;
+  scene_view view;
+  material_table materials;
+  hittable_list objects;
+};
+
+// The random sphere field of "Ray Tracing in One Weekend": 500 small spheres with
+// mixed materials around three large ones, on a huge ground sphere.
+void make_sphere_field(bench_scene& s) {
+  s.name = "spheres500";
+  s.view.aspect_ratio = 16.0 / 9.0;
+  s.view.max_depth = 10;
+  s.view.v_fov = 20;
+  const double look_from[3] = {13, 2, 3};
+  std::copy(look_from, look_from + 3, s.view.look_from);
+  std::fill(s.view.look_at, s.view.look_at + 3, 0.0);
+
+  std::mt19937_64 rng(2024);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  s.objects.add(std::make_shared<sphere>(point3(0, -1000, 0), 1000, s.materials.emplace<lambertian>(color(0.5, 0.5, 0.5))));
+  int placed = 0;
+  for (int a = -11; a < 11 && placed < 497; ++a) {
+    for (int b = -11; b < 12 && placed < 497; ++b) {
+      point3 center(a + 0.9 * uniform(rng), 0.2, b + 0.9 * uniform(rng));
+      double choice = uniform(rng);
+      material_id mat;
+      if (choice < 0.8) {
+        mat = s.materials.emplace<lambertian>(color(uniform(rng) * uniform(rng), uniform(rng) * uniform(rng),
+                                                    uniform(rng) * uniform(rng)));
+      } else if (choice < 0.95) {
+        mat = s.materials.emplace<metal>(color(0.5 + 0.5 * uniform(rng), 0.5 + 0.5 * uniform(rng),
+                                               0.5 + 0.5 * uniform(rng)), 0.5 * uniform(rng));
+      } else {
+        mat = s.materials.emplace<dielectric>(1.5);
+      }
+      s.objects.add(std::make_shared<sphere>(center, 0.2, mat));
+      ++placed;
+    }
+  }
+  s.objects.add(std::make_shared<sphere>(point3(0, 1, 0), 1.0, s.materials.emplace<dielectric>(1.5)));
+  s.objects.add(std::make_shared<sphere>(point3(-4, 1, 0), 1.0, s.materials.emplace<lambertian>(color(0.4, 0.2, 0.1))));
+  s.objects.add(std::make_shared<sphere>(point3(4, 1, 0), 1.0, s.materials.emplace<metal>(color(0.7, 0.6, 0.5), 0.0)));
+}
+
+// A 24 x 24 city block of boxes of random heights, a few of them glass or metal
+void make_box_field(bench_scene& s) {
+  s.name = "boxes";
+  s.view.aspect_ratio = 16.0 / 9.0;
+  s.view.max_depth = 10;
+  s.view.v_fov = 40;
+  const double look_from[3] = {0, 9, 14};
+  const double look_at[3] = {0, 0, -2};
+  std::copy(look_from, look_from + 3, s.view.look_from);
+  std::copy(look_at, look_at + 3, s.view.look_at);
+
+  std::mt19937_64 rng(99);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  s.objects.add(std::make_shared<plane>(point3(0, 0, 0), vec3(0, 1, 0), s.materials.emplace<lambertian>(color(0.3, 0.3, 0.3))));
+  const material_id diffuse = s.materials.emplace<lambertian>(color(0.7, 0.6, 0.5));
+  const material_id shiny = s.materials.emplace<metal>(color(0.8, 0.8, 0.9), 0.05);
+  const material_id glass = s.materials.emplace<dielectric>(1.5);
+  for (int x = 0; x < 24; ++x) {
+    for (int z = 0; z < 24; ++z) {
+      double x0 = (x - 12) * 1.0 + 0.1;
+      double z0 = (z - 20) * 1.0 + 0.1;
+      double height = 0.2 + 2.0 * uniform(rng) * uniform(rng);
+      double choice = uniform(rng);
+      material_id mat = choice < 0.85 ? diffuse : (choice < 0.95 ? shiny : glass);
+      s.objects.add(std::make_shared<box>(point3(x0, 0, z0), point3(x0 + 0.8, height, z0 + 0.8), mat));
+    }
+  }
+}
+
+// Renders a scene at 1, 2, 4, ... threads up to the maximum and reports throughput
+// and speedup over one thread. Every run traces the same rays (fixed seed), so the
+// ray count is measured once with a counting wrapper and reused.
+std::string run_scene(const options& opts, const std::string& name, const scene_view& view, const hittable& world,
+                      const material_table& materials) {
+  const int width = opts.quick ? 160 : 400;
+  const int spp = opts.quick ? 4 : 32;
+
+  auto make_camera = [&](int threads) {
+    camera cam("/dev/null");
+    view.apply(cam);
+    cam.image_width = width;
+    cam.samples_per_pixel = spp;
+    cam.thread_count = threads;
+    cam.seed = 1;
+    return cam;
+  };
+
+  // The camera reports progress on std::cout, which carries the JSON.
+  std::streambuf* stdout_buffer = std::cout.rdbuf(nullptr);
+
+  counting_world counter(world);
+  make_camera(1).render(counter, materials);
+  const uint64_t rays = counter.count;
+  const int height = std::max(1, static_cast<int>(width / view.aspect_ratio));
+  const double samples = static_cast<double>(width) * height * spp;
+
+  const unsigned hw = std::thread::hardware_concurrency();
+  const int max_threads = opts.max_threads > 0 ? opts.max_threads : (hw == 0 ? 4 : static_cast<int>(hw));
+  std::vector<int> thread_counts;
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  std::vector<std::string> runs;
+  double single_thread_seconds = 0;
+  for (int threads : thread_counts) {
+    auto start = bench_clock::now();
+    make_camera(threads).render(world, materials);
+    double seconds = seconds_since(start);
+    if (threads == 1) single_thread_seconds = seconds;
+    double speedup = single_thread_seconds > 0 ? single_thread_seconds / seconds : 1.0;
+
+    std::cerr << "  " << name << " @" << threads << " threads: " << seconds << " s, " << rays / seconds * 1e-6
+              << " Mrays/s" << std::endl;
+    runs.push_back("        {\"threads\": " + std::to_string(threads) + ", \"seconds\": " + json_number(seconds) +
+                   ", \"mrays_per_s\": " + json_number(rays / seconds * 1e-6) +
+                   ", \"samples_per_s\": " + json_number(samples / seconds) +
+                   ", \"speedup\": " + json_number(speedup) +
+                   ", \"efficiency\": " + json_number(speedup / threads) + "}");
+  }
+  std::cout.rdbuf(stdout_buffer);
+  std::cout.clear();
+
+  std::string json = "    {\"name\": \"" + name + "\", \"width\": " + std::to_string(width) +
+                     ", \"height\": " + std::to_string(height) + ", \"spp\": " + std::to_string(spp) +
+                     ", \"rays\": " + std::to_string(rays) + ", \"runs\": [\n";
+  for (size_t k = 0; k < runs.size(); ++k) {
+    json += runs[k] + (k + 1 < runs.size() ? ",\n" : "\n");
+  }
+  return json + "    ]}";
+}
+
+bool selected(const options& opts, const std::string& name) {
+  return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+}
+
+std::string join(const std::vector<std::string>& items) {
+  std::string out;
+  for (size_t k = 0; k < items.size(); ++k) {
+    out += items[k] + (k + 1 < items.size() ? ",\n" : "\n");
+  }
+  return out;
+}
+
+}
+
+signed main(int argc, char** argv) {
+  options opts;
+  for (int k = 1; k < argc; ++k) {
+    std::string arg = argv[k];
+    if (arg == "--quick") {
+      opts.quick = true;
+    } else if (arg == "--threads" && k + 1 < argc) {
+      opts.max_threads = std::stoi(argv[++k]);
+    } else if (arg == "--filter" && k + 1 < argc) {
+      opts.filter = argv[++k];
+    } else {
+      std::cerr << "Usage: raytracing_bench [--quick] [--threads N] [--filter S]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::cerr << "Microbenchmarks" << std::endl;
+  micro_suite suite(opts);
+  run_intersectors(suite);
+  run_materials(suite);
+  run_rng(suite);
+  run_vec3(suite);
+
+  std::cerr << "Scenes" << std::endl;
+  std::vector<std::string> scenes;
+  if (selected(opts, "demo")) {
+    scene demo;
+    if (!demo.load(std::string(RAYTRACING_SCENE_DIR) + "/default.scene")) {
+      return 1;
+    }
+    bvh world(demo.world);
+    scenes.push_back(run_scene(opts, "demo", demo.view, world, demo.materials));
+  }
+  for (auto make : {make_sphere_field, make_box_field}) {
+    bench_scene s;
+    make(s);
+    if (!selected(opts, s.name)) continue;
+    bvh world(s.objects);
+    scenes.push_back(run_scene(opts, s.name, s.view, world, s.materials));
+  }
+
+  const unsigned hw = std::thread::hardware_concurrency();
+  std::cout << "{\n"
+            << "  \"hardware_threads\": " << hw << ",\n"
+            << "  \"real\": \"" << (sizeof(real) == sizeof(float) ? "float" : "double") << "\",\n"
+            << "  \"simd_width\": " << sphere_set::simd_width() << ",\n"
+            << "  \"quick\": " << (opts.quick ? "true" : "false") << ",\n"
+            << "  \"micro\": [\n" << join(suite.results) << "  ],\n"
+            << "  \"scenes\": [\n" << join(scenes) << "  ]\n"
+            << "}" << std::endl;
+  return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef __ALIGNED_ALLOCATOR_HPP__
+#define __ALIGNED_ALLOCATOR_HPP__
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Allocator handing out storage aligned to Alignment bytes, so structure-of-arrays
+// data can be read with aligned SIMD loads.
+template <typename T, std::size_t Alignment = 64>
+class aligned_allocator {
+public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = aligned_allocator<U, Alignment>;
+  };
+
+  aligned_allocator() = default;
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Alignment>&) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(T* p, std::size_t) {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U, Alignment>&) const { return true; }
+  template <typename U>
+  bool operator!=(const aligned_allocator<U, Alignment>&) const { return false; }
+};
+
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+#endif
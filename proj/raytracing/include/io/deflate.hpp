@@ -0,0 +1,21 @@
+#ifndef __DEFLATE_HPP__
+#define __DEFLATE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Minimal DEFLATE (RFC 1951) encoder: greedy LZ77 over hash chains followed by
+// dynamic Huffman blocks. Input can be compressed as independent chunks: every
+// non-final chunk ends on a byte boundary (an empty stored block, as in a zlib
+// sync flush), so chunks compressed on different threads concatenate into one
+// valid stream. Chunks do not reference each other's data.
+std::vector<uint8_t> deflate_chunk(const uint8_t* data, size_t size, bool final_chunk);
+
+// Checksums used by the zlib and PNG containers
+uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+// Adler-32 of A followed by B, given adler32(A), adler32(B) and B's length
+uint32_t adler32_combine(uint32_t adler_a, uint32_t adler_b, size_t size_b);
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __IMAGE_WRITER_HPP__
+#define __IMAGE_WRITER_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <objects/color.hpp>
+
+// Writes a linear-radiance framebuffer (row-major, top row first) to disk.
+// Writers split their per-pixel work into row chunks encoded on thread_count threads.
+class image_writer {
+public:
+  int thread_count = 1;
+
+  virtual ~image_writer() = default;
+  virtual bool write(const std::string& path, int width, int height, const std::vector<color>& pixels) const = 0;
+
+  // Picks a writer from the file extension: .png, .pfm, .exr, otherwise binary PPM.
+  static std::unique_ptr<image_writer> for_path(const std::string& path, int thread_count = 1);
+
+protected:
+  // Calls fn(first_row, end_row) for disjoint row ranges covering [0, height).
+  void parallel_rows(int height, const std::function<void(int, int)>& fn) const;
+  // Gamma-corrects (gamma 2), clamps and quantizes count colors to 8-bit RGB,
+  // several channels per instruction; matches get_color_byte exactly.
+  static void to_display_bytes(const color* pixels, size_t count, uint8_t* out);
+};
+
+// Binary PPM (P6)
+class ppm_writer: public image_writer {
+public:
+  bool write(const std::string& path, int width, int height, const std::vector<color>& pixels) const override;
+};
+
+// 8-bit RGB PNG. Filtered scanlines are deflated in independent row chunks in
+// parallel and stitched into a single zlib stream.
+class png_writer: public image_writer {
+public:
+  bool write(const std::string& path, int width, int height, const std::vector<color>& pixels) const override;
+};
+
+// Portable float map: linear 32-bit float RGB, no gamma or clamping
+class pfm_writer: public image_writer {
+public:
+  bool write(const std::string& path, int width, int height, const std::vector<color>& pixels) const override;
+};
+
+// Uncompressed scanline OpenEXR with 32-bit float R, G, B channels
+class exr_writer: public image_writer {
+public:
+  bool write(const std::string& path, int width, int height, const std::vector<color>& pixels) const override;
+};
+
+#endif
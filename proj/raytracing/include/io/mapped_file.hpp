@@ -0,0 +1,28 @@
+#ifndef __MAPPED_FILE_HPP__
+#define __MAPPED_FILE_HPP__
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (POSIX mmap). The contents are paged
+// in on first touch, so opening even a very large file costs next to nothing.
+class mapped_file {
+public:
+  mapped_file() {}
+  ~mapped_file();
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  // Maps path, replacing any previous mapping; returns false if it cannot be mapped.
+  bool open(const std::string& path);
+  void close();
+
+  const unsigned char* data() const { return bytes; }
+  size_t size() const { return length; }
+
+private:
+  const unsigned char* bytes = nullptr;
+  size_t length = 0;
+};
+
+#endif
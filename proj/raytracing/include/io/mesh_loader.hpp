@@ -0,0 +1,18 @@
+#ifndef __MESH_LOADER_HPP__
+#define __MESH_LOADER_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <objects/vec3.hpp>
+
+// Reads the triangles of a Wavefront OBJ (.obj) or PLY (.ply; binary little- or
+// big-endian, or ASCII) file into a vertex buffer and an index buffer with three
+// indices per triangle. Polygons are fan-triangulated; normals, texture
+// coordinates and other attributes are skipped. The file is memory-mapped and
+// parsed in one pass without copying it into a stream.
+// Errors are reported on std::cerr.
+bool load_mesh(const std::string& path, std::vector<point3>& vertices, std::vector<uint32_t>& indices);
+
+#endif
@@ -11,6 +11,17 @@ public:
   virtual ~material() = default;
   
   virtual bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const = 0;
+  // Surface colour at the hit, for the denoiser's albedo buffer. White unless the
+  // material has a colour of its own.
+  virtual color surface_albedo(const hit_record&) const { return color(1, 1, 1); }
+  // Radiance the surface emits toward the ray that hit it
+  virtual color emitted(const hit_record&) const { return color(0, 0, 0); }
+
+  // For light sampling: BSDF times cosine for light arriving from direction, and
+  // the solid-angle density with which scatter() picks direction. Both are zero
+  // for specular materials, which light sampling skips.
+  virtual color evaluate(const ray&, const hit_record&, const vec3&) const { return color(0, 0, 0); }
+  virtual double scattering_pdf(const ray&, const hit_record&, const vec3&) const { return 0.0; }
 };
 
 #endif
\ No newline at end of file
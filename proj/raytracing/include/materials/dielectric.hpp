@@ -54,7 +54,9 @@ private:
   static double reflectance(double cosine, double ref_idx) {
     double r0 = (1 - ref_idx) / (1 + ref_idx);
     r0 = r0 * r0;
-    return r0 + (1 - r0) * std::pow(1 - cosine, 5);
+    double m = 1 - cosine;
+    double m2 = m * m;
+    return r0 + (1 - r0) * (m2 * m2 * m);
   }
 };
 
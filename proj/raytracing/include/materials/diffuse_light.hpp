@@ -0,0 +1,21 @@
+#ifndef __DIFFUSE_LIGHT_HPP__
+#define __DIFFUSE_LIGHT_HPP__
+
+#include <materials/base.hpp>
+
+// Emits radiance from the front side of a surface (outside of spheres and boxes,
+// the side a quad's normal points to) and reflects nothing.
+class diffuse_light : public material {
+public:
+  color radiance;
+
+  explicit diffuse_light(const color& c) : radiance(c) {}
+
+  bool scatter(const ray&, const hit_record&, color&, ray&) const override { return false; }
+  color surface_albedo(const hit_record&) const override { return radiance; }
+  color emitted(const hit_record& rec) const override {
+    return rec.front_face ? radiance : color(0, 0, 0);
+  }
+};
+
+#endif
@@ -10,6 +10,9 @@ public:
   lambertian(const color& a) : albedo(a) {}
 
   bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const override;
+  color surface_albedo(const hit_record&) const override { return albedo; }
+  color evaluate(const ray& r_in, const hit_record& rec, const vec3& direction) const override;
+  double scattering_pdf(const ray& r_in, const hit_record& rec, const vec3& direction) const override;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef __MATERIAL_TABLE_HPP__
+#define __MATERIAL_TABLE_HPP__
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <materials/base.hpp>
+
+// Owns every material of a scene. Shapes and hit records refer to materials by
+// their material_id (index into the table), so recording a hit copies a 32-bit
+// integer instead of bumping a shared reference count.
+class material_table {
+public:
+  material_table() {}
+  material_table(const material_table&) = delete;
+  material_table& operator=(const material_table&) = delete;
+
+  material_id add(std::unique_ptr<material> mat);
+
+  template <typename T, typename... Args>
+  material_id emplace(Args&&... args) {
+    return add(std::make_unique<T>(std::forward<Args>(args)...));
+  }
+
+  const material& operator[](material_id id) const { return *materials[id]; }
+  size_t size() const { return materials.size(); }
+  void clear() { materials.clear(); }
+
+  // Scatters through material id; no_material absorbs the ray.
+  bool scatter(material_id id, const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const {
+    return id != no_material && materials[id]->scatter(r_in, rec, attenuation, scattered);
+  }
+  // Albedo of material id at the hit; no_material is black.
+  color albedo(material_id id, const hit_record& rec) const {
+    return id != no_material ? materials[id]->surface_albedo(rec) : color(0, 0, 0);
+  }
+  color emitted(material_id id, const hit_record& rec) const {
+    return id != no_material ? materials[id]->emitted(rec) : color(0, 0, 0);
+  }
+  color evaluate(material_id id, const ray& r_in, const hit_record& rec, const vec3& direction) const {
+    return id != no_material ? materials[id]->evaluate(r_in, rec, direction) : color(0, 0, 0);
+  }
+  double scattering_pdf(material_id id, const ray& r_in, const hit_record& rec, const vec3& direction) const {
+    return id != no_material ? materials[id]->scattering_pdf(r_in, rec, direction) : 0.0;
+  }
+
+private:
+  std::vector<std::unique_ptr<material>> materials;
+};
+
+#endif
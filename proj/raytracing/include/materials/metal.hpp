@@ -11,6 +11,7 @@ public:
   metal(const color& a, double f) : albedo(a), fuzz(f < 1 ? f : 1) {}
 
   bool scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const override;
+  color surface_albedo(const hit_record&) const override { return albedo; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef __AABB_HPP__
+#define __AABB_HPP__
+
+#include <objects/interval.hpp>
+#include <objects/ray.hpp>
+#include <objects/vec3.hpp>
+
+// Axis-aligned bounding box stored as one interval per axis.
+// Used by acceleration structures; shapes report theirs via hittable::bounding_box().
+class aabb {
+public:
+  interval x, y, z;
+
+  // The default box is empty, so it can be grown with the union constructor.
+  aabb() {}
+  aabb(const interval& _x, const interval& _y, const interval& _z);
+  // Box spanning two corner points (in any order)
+  aabb(const point3& a, const point3& b);
+  // Tightest box enclosing both boxes
+  aabb(const aabb& box0, const aabb& box1);
+
+  const interval& axis_interval(int n) const;
+  point3 centroid() const;
+  int longest_axis() const;
+  double surface_area() const;
+  // False if any side extends to infinity (e.g. an infinite plane)
+  bool is_bounded() const;
+
+  bool hit(const ray& r, interval ray_interval) const;
+
+  static const aabb empty;
+  static const aabb universe;
+
+private:
+  // Give zero-thickness boxes (e.g. axis-aligned quads) a tiny extent
+  void pad_to_minimums();
+};
+
+// Inline: slab tests in BVH traversal call it for every node visited
+inline const interval& aabb::axis_interval(int n) const {
+  if (n == 1) {
+    return y;
+  }
+  if (n == 2) {
+    return z;
+  }
+  return x;
+}
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef __BVH_HPP__
+#define __BVH_HPP__
+
+#include <cstdint>
+#include <utility>
+#include <memory>
+#include <vector>
+
+#include <objects/aabb.hpp>
+#include <objects/hittable.hpp>
+#include <objects/interval.hpp>
+#include <objects/ray.hpp>
+#include <objects/ray_packet.hpp>
+
+#include <render/render_stats.hpp>
+
+#include <real.hpp>
+
+// One node of a flattened bounding volume hierarchy, sized to a single cache line
+// (half of one with float boxes, so two siblings share a line). Nodes are stored
+// depth-first: an interior node's first child is the next node in the array, so
+// descending to the near child usually touches memory already loaded.
+struct alignas(8 * sizeof(real)) bvh_node {
+  aabb box;
+  // Interior: index of the second child. Leaf: first slot in bvh_tree::indices.
+  uint32_t offset = 0;
+  // Number of primitives in a leaf; 0 marks an interior node.
+  uint16_t count = 0;
+  // Split axis, used to visit the child nearer to the ray origin first.
+  uint8_t axis = 0;
+};
+
+// Primitive-agnostic BVH built with the binned surface area heuristic (SAH).
+// The owner supplies one bounding box per primitive and a leaf callback; this lets
+// hittable collections and meshes share the same builder and traversal.
+class bvh_tree {
+public:
+  std::vector<bvh_node> nodes;
+  // Leaf order: slot k holds the index of the k-th primitive in the input.
+  std::vector<uint32_t> indices;
+
+  void build(const std::vector<aabb>& primitive_boxes);
+  aabb bounds() const;
+
+  // Walks the tree front-to-back. For each primitive in a visited leaf calls
+  // intersect_primitive(slot, ray_interval), which must return true on a hit and
+  // shrink ray_interval.max to the hit distance so farther nodes get culled.
+  template <typename LeafFn>
+  bool traverse(const ray& r, interval ray_interval, LeafFn&& intersect_primitive) const;
+
+  // Any-hit walk: calls occludes_primitive(slot, ray_interval) for primitives in
+  // visited leaves and returns true as soon as one of them does.
+  template <typename LeafFn>
+  bool traverse_any(const ray& r, interval ray_interval, LeafFn&& occludes_primitive) const;
+
+  // Packet variant: each node is first culled against the packet frustum, then
+  // slab-tested per lane; only lanes that reach a leaf are passed on through
+  // intersect_primitive(slot, lanes), which returns the lanes it hit.
+  template <typename LeafFn>
+  uint32_t traverse_packet(const ray_packet& packet, uint32_t active, LeafFn&& intersect_primitive) const;
+
+private:
+  // SAH splits stop at max_depth; the median splits below it add at most 32 more
+  // levels, which keeps traversal within the fixed-size stack.
+  static constexpr int max_depth = 48;
+  static constexpr int stack_size = 96;
+
+  // Min/max corners, grown inline while building (defined in bvh.cpp)
+  struct build_box;
+
+  uint32_t build_recursive(const std::vector<build_box>& primitive_boxes, const std::vector<point3>& centroids,
+                           uint32_t begin, uint32_t end, int depth);
+  static bool hit_node(const aabb& box, const point3& origin, const vec3& inv_dir, const interval& ray_interval);
+};
+
+// Drop-in hittable wrapping a bvh_tree over a set of objects.
+// Objects with unbounded boxes (infinite planes) are kept in a separate list and
+// tested after the tree, so they neither bloat the root box nor defeat culling.
+class bvh: public hittable {
+public:
+  explicit bvh(const hittable_list& list);
+  explicit bvh(std::vector<std::shared_ptr<hittable>> objects);
+
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override;
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override;
+  aabb bounding_box() const override;
+  uint32_t hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const override;
+  bool occluded(const ray& r, interval ray_interval) const override;
+
+  size_t node_count() const;
+
+private:
+  bvh_tree tree;
+  // Bounded objects in leaf order, so a leaf reads a contiguous range.
+  std::vector<std::shared_ptr<hittable>> primitives;
+  hittable_list unbounded;
+  aabb bbox;
+};
+
+inline bool bvh_tree::hit_node(const aabb& box, const point3& origin, const vec3& inv_dir, const interval& ray_interval) {
+  real t_enter = ray_interval.min;
+  real t_exit = ray_interval.max;
+  for (int axis = 0; axis < 3; ++axis) {
+    const interval& slab = box.axis_interval(axis);
+    real t0 = (slab.min - origin[axis]) * inv_dir[axis];
+    real t1 = (slab.max - origin[axis]) * inv_dir[axis];
+    if (t0 > t1) std::swap(t0, t1);
+    // NaN (ray lying on a slab plane) fails both comparisons and is ignored.
+    if (t0 > t_enter) t_enter = t0;
+    if (t1 < t_exit) t_exit = t1;
+  }
+  return t_enter <= t_exit;
+}
+
+template <typename LeafFn>
+bool bvh_tree::traverse(const ray& r, interval ray_interval, LeafFn&& intersect_primitive) const {
+  if (nodes.empty()) {
+    return false;
+  }
+
+  const point3& origin = r.origin();
+  const vec3& direction = r.direction();
+  const vec3 inv_dir(1 / direction.x(), 1 / direction.y(), 1 / direction.z());
+  const bool dir_negative[3] = {inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0};
+
+  uint32_t stack[stack_size];
+  int stack_top = 0;
+  uint32_t current = 0;
+  bool hit_anything = false;
+
+  while (true) {
+    RT_STAT_INC(bvh_nodes_visited);
+    const bvh_node& node = nodes[current];
+    if (hit_node(node.box, origin, inv_dir, ray_interval)) {
+      if (node.count > 0) {
+        for (uint32_t i = 0; i < node.count; ++i) {
+          if (intersect_primitive(node.offset + i, ray_interval)) {
+            hit_anything = true;
+          }
+        }
+        if (stack_top == 0) break;
+        current = stack[--stack_top];
+      } else if (dir_negative[node.axis]) {
+        // Ray travels toward -axis: the second (upper) child is nearer.
+        stack[stack_top++] = current + 1;
+        current = node.offset;
+      } else {
+        stack[stack_top++] = node.offset;
+        current = current + 1;
+      }
+    } else {
+      if (stack_top == 0) break;
+      current = stack[--stack_top];
+    }
+  }
+
+  return hit_anything;
+}
+
+template <typename LeafFn>
+bool bvh_tree::traverse_any(const ray& r, interval ray_interval, LeafFn&& occludes_primitive) const {
+  if (nodes.empty()) {
+    return false;
+  }
+
+  const point3& origin = r.origin();
+  const vec3& direction = r.direction();
+  const vec3 inv_dir(1 / direction.x(), 1 / direction.y(), 1 / direction.z());
+  const bool dir_negative[3] = {inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0};
+
+  uint32_t stack[stack_size];
+  int stack_top = 0;
+  uint32_t current = 0;
+
+  while (true) {
+    RT_STAT_INC(bvh_nodes_visited);
+    const bvh_node& node = nodes[current];
+    if (hit_node(node.box, origin, inv_dir, ray_interval)) {
+      if (node.count > 0) {
+        for (uint32_t i = 0; i < node.count; ++i) {
+          if (occludes_primitive(node.offset + i, ray_interval)) {
+            return true;
+          }
+        }
+        if (stack_top == 0) break;
+        current = stack[--stack_top];
+      } else if (dir_negative[node.axis]) {
+        // Near child first still pays off: nearby occluders are the likely ones.
+        stack[stack_top++] = current + 1;
+        current = node.offset;
+      } else {
+        stack[stack_top++] = node.offset;
+        current = current + 1;
+      }
+    } else {
+      if (stack_top == 0) break;
+      current = stack[--stack_top];
+    }
+  }
+
+  return false;
+}
+
+template <typename LeafFn>
+uint32_t bvh_tree::traverse_packet(const ray_packet& packet, uint32_t active, LeafFn&& intersect_primitive) const {
+  if (nodes.empty() || active == 0) {
+    return 0;
+  }
+
+  struct entry {
+    uint32_t node;
+    uint32_t lanes;
+  };
+  entry stack[stack_size];
+  int stack_top = 0;
+  stack[stack_top++] = {0, active};
+  uint32_t hits = 0;
+
+  while (stack_top > 0) {
+    entry current = stack[--stack_top];
+    const bvh_node& node = nodes[current.node];
+    RT_STAT_INC(bvh_nodes_visited);
+
+    if (packet.frustum_misses(node.box, current.lanes)) {
+      continue;
+    }
+    uint32_t lanes = packet.hit_lanes(node.box, current.lanes);
+    if (lanes == 0) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (uint32_t i = 0; i < node.count; ++i) {
+        hits |= intersect_primitive(node.offset + i, lanes);
+      }
+    } else if (packet.direction_negative(node.axis, lanes)) {
+      stack[stack_top++] = {current.node + 1, lanes};
+      stack[stack_top++] = {node.offset, lanes};
+    } else {
+      stack[stack_top++] = {node.offset, lanes};
+      stack[stack_top++] = {current.node + 1, lanes};
+    }
+  }
+
+  return hits;
+}
+
+#endif
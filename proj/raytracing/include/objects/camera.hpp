@@ -1,37 +1,141 @@
 #ifndef __CAMERA_HPP__
 #define __CAMERA_HPP__
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <objects/color.hpp>
 #include <objects/hittable.hpp>
+#include <objects/ray_packet.hpp>
 #include <objects/vec3.hpp>
 
+#include <materials/material_table.hpp>
+
+#include <render/accumulation_buffer.hpp>
+#include <render/denoiser.hpp>
+#include <render/render_stats.hpp>
+#include <render/sampler.hpp>
+#include <render/tile_scheduler.hpp>
+
 class camera {
 public:
   double aspect_ratio = 1.0;
   int image_width = 100;
   int samples_per_pixel = 10;
   int max_depth = 10;
+  // Paths that have bounced this many times are randomly terminated in proportion
+  // to how little light they still carry (Russian roulette); 0 disables it.
+  int roulette_depth = 3;
   point3 look_from = point3(0, 0, 0);
   point3 look_at = point3(0, 0, -1);
   vec3 v_up = vec3(0, 1, 0);
   double v_fov = 90.0;
+  // Thin lens: rays start on a disk that subtends defocus_angle degrees seen from
+  // the plane in focus, focus_dist in front of the camera. 0 is a pinhole.
+  double defocus_angle = 0.0;
+  double focus_dist = 10.0;
+  // Rays that escape see the sky gradient, or background_color when use_sky is off
+  bool use_sky = true;
+  color background_color = color(0, 0, 0);
+  // Trace primary rays in 4x4 packets; bounces after the first hit are traced singly.
+  bool use_ray_packets = false;
+  // Use the wavefront integrator, which advances a queue of paths one stage at a
+  // time, instead of tracing each path recursively. Overrides use_ray_packets.
+  bool use_wavefront = false;
+  // Paths a tile keeps in flight in the wavefront integrator
+  int wavefront_size = 16384;
+  // Worker threads; 0 uses std::thread::hardware_concurrency()
+  int thread_count = 0;
+  // Edge length in pixels of the tiles handed out to worker threads
+  int tile_size = 32;
+  // Progressive rendering: samples are added in passes of this many per pixel
+  // (0 renders everything in a single pass, or checkpoint_pass_samples at a time
+  // when checkpointing).
+  int samples_per_pass = 0;
+  // If set, the accumulated samples are saved here between passes and a matching
+  // checkpoint found at start-up is resumed (or extended to more samples_per_pixel).
+  std::string checkpoint_path;
+  // Checkpoints are written between passes, so without an explicit
+  // samples_per_pass a checkpointed render uses passes of this many samples.
+  int checkpoint_pass_samples = 16;
+  // Minimum seconds between checkpoint writes; the finished render is always saved.
+  double checkpoint_interval = 60.0;
+  // Adaptive sampling: a pixel stops taking samples once the 95% confidence
+  // interval of its displayed (gamma-corrected) value is narrower than this
+  // (e.g. 0.01). 0 disables it; samples_per_pixel is then used for every pixel.
+  double adaptive_threshold = 0.0;
+  // Samples every pixel takes before its noise estimate is trusted
+  int adaptive_min_samples = 16;
+  // If set, a grayscale map of per-pixel sample counts is written here.
+  std::string sample_map_path;
+  // Identifies the scene being rendered (scene::fingerprint). It is part of the
+  // checkpoint fingerprint, so a checkpoint of other scene content is never resumed.
+  uint64_t scene_fingerprint = 0;
+  // Seed of the counter-based random streams; a given seed renders the same image
+  // regardless of thread_count, tile_size or use_ray_packets.
+  uint64_t seed = 0;
+  // How pixel, lens and bounce dimensions are drawn; see sampler_kind
+  sampler_kind sampling = sampler_kind::independent;
+  // Distributed rendering: this process renders only part tile_part of
+  // tile_part_count (see tile_scheduler).
+  int tile_part = 0;
+  int tile_part_count = 1;
+  // If set, the accumulated sums and sample counts are written here (checkpoint
+  // format) instead of an image, for the merge tool to combine with other parts.
+  std::string partial_path;
+  // Builds with RAYTRACING_STATS: the last render's statistics, printed to stdout
+  // at the end and also written to stats_path as JSON when that is set.
+  render_stats stats;
+  std::string stats_path;
+  // Run the edge-aware denoiser over the finished image before writing it. It is
+  // guided by albedo, normal and depth buffers traced from aov_samples extra
+  // camera rays per pixel.
+  bool denoise = false;
+  denoiser filter;
+  int aov_samples = 4;
+  // If set, the albedo, normal and depth buffers are also written as
+  // <aov_path>.albedo.pfm, <aov_path>.normal.pfm and <aov_path>.depth.pfm.
+  std::string aov_path;
 
   camera(std::string file_path): file_path(file_path) {}
-  void render(const hittable& world);
+  // Renders world, whose hit records refer to materials in scene_materials.
+  // Emitters in scene_lights are sampled directly at every diffuse bounce.
+  void render(const hittable& world, const material_table& scene_materials,
+              const hittable_list* scene_lights = nullptr);
 private:
   std::string file_path;
+  const material_table* materials = nullptr;
+  const hittable_list* lights = nullptr;
   int image_height;
-  double pixel_samples_scale;
   point3 camera_position;
   point3 upper_left_corner_pixel;
   vec3 pixel_delta_u, pixel_delta_v;
+  vec3 defocus_disk_u, defocus_disk_v;
+  sampler pattern;
 
   void initialize();
   ray get_ray(int i, int j) const;
   vec3 sample_square() const;
-  color get_ray_color(const ray&r, int depth, const hittable& world) const;
+  point3 defocus_disk_sample() const;
+  void start_sample(int i, int j, uint32_t sample) const;
+  color get_ray_color(const ray& r, const hittable& world) const;
+  color trace_from_hit(ray r, hit_record rec, const hittable& world) const;
+  bool survives_roulette(int bounce, color& throughput) const;
+  color sample_lights(const ray& r_in, const hit_record& rec, const hittable& world) const;
+  double emission_weight(const ray& r, double scatter_pdf) const;
+  color background(const ray& r) const;
+  void render_tile(const tile& t, const hittable& world, const accumulation_buffer& accum, int pass_samples,
+                   accumulation_buffer& local) const;
+  void render_packet_block(const tile& t, int row, int col, const hittable& world, const accumulation_buffer& accum,
+                           int pass_samples, accumulation_buffer& local) const;
+  void render_tile_wavefront(const tile& t, const hittable& world, const accumulation_buffer& accum, int pass_samples,
+                             accumulation_buffer& local) const;
+  int pixel_pass_samples(const accumulation_buffer& accum, int i, int j, int pass_samples) const;
+  void write_sample_map(const accumulation_buffer& accum) const;
+  void render_aovs(const hittable& world, int workers, aov_buffer& aovs) const;
+  void write_aovs(const aov_buffer& aovs, int workers) const;
+  uint64_t fingerprint() const;
 };
 
 #endif
\ No newline at end of file
@@ -8,6 +8,12 @@
 using color = vec3;
 
 double linear_to_gamma(double linear);
+
+// Rec. 709 relative luminance of a linear color
+template <typename T>
+T luminance(const basic_vec3<T>& c) {
+  return static_cast<T>(0.2126) * c.x() + static_cast<T>(0.7152) * c.y() + static_cast<T>(0.0722) * c.z();
+}
 color get_color_byte(color c);
 
 #endif
\ No newline at end of file
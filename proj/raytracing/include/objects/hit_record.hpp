@@ -1,12 +1,15 @@
 #ifndef __HIT_RECORD_HPP__
 #define __HIT_RECORD_HPP__
 
-#include <memory>
+#include <cstdint>
+
 #include <objects/color.hpp>
 #include <objects/ray.hpp>
 #include <objects/vec3.hpp>
 
-class material;
+// Index of a material in the scene's material_table
+using material_id = uint32_t;
+constexpr material_id no_material = 0xffffffffu;
 
 class hit_record {
 public:
@@ -14,7 +17,7 @@ public:
   vec3 normal;
   double t;
   bool front_face;
-  std::shared_ptr<material> mat;
+  material_id mat = no_material;
   
   void set_face_normal(const ray& r, const vec3& outward_normal);
 };
@@ -4,14 +4,48 @@
 #include <memory>
 #include <vector>
 
+#include <objects/aabb.hpp>
 #include <objects/hit_record.hpp>
+#include <objects/intersection.hpp>
 #include <objects/interval.hpp>
 #include <objects/ray.hpp>
+#include <objects/ray_packet.hpp>
 
+// Intersection is split in two phases: intersect() only finds the distance and
+// identity of the closest hit, and surface_interaction() computes the position,
+// normal and material once for the hit that wins. Candidates that a closer hit
+// later replaces never pay for shading data.
 class hittable {
 public:
   virtual ~hittable() = default;
-  virtual bool hit(const ray& r, interval ray_interval, hit_record& rec) const = 0;
+  // Finds the closest hit inside ray_interval. Leaf shapes set isect.object to
+  // themselves; aggregates pass through the object of the primitive they hit.
+  virtual bool intersect(const ray& r, interval ray_interval, intersection& isect) const = 0;
+  // Fills rec for a hit that intersect() reported with isect.object == this.
+  virtual void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const = 0;
+  // World-space bounds; unbounded shapes (planes) return aabb::universe.
+  virtual aabb bounding_box() const = 0;
+
+  // Intersects the active lanes of a packet. A lane only accepts a hit closer than
+  // packet.t_max[lane]; on a hit it lowers t_max, overwrites isects[lane] and its bit
+  // is set in the returned mask. The default traces each active lane as a single ray.
+  virtual uint32_t hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const;
+
+  // intersect() followed by surface_interaction() on the object that was hit
+  bool hit(const ray& r, interval ray_interval, hit_record& rec) const;
+
+  // Any-hit query for shadow and visibility rays: true if anything lies inside
+  // ray_interval. Aggregates return at the first hit they find instead of
+  // searching for the closest. The default is intersect(), which for a single
+  // shape is already no more work than that.
+  virtual bool occluded(const ray& r, interval ray_interval) const;
+
+  // Light sampling, for shapes the integrator samples directly: a direction from
+  // origin toward a random point of the shape, and the solid-angle density with
+  // which random_direction(origin) picks direction (0 if it misses the shape).
+  // Shapes that cannot be sampled report density 0.
+  virtual vec3 random_direction(const point3& origin) const;
+  virtual double pdf_value(const point3& origin, const vec3& direction) const;
 };
 
 class hittable_list: public hittable {
@@ -22,7 +56,17 @@ public:
   hittable_list(std::shared_ptr<hittable> object);
   void clear();
   void add(std::shared_ptr<hittable> object);
-  bool hit(const ray& r, interval ray_interval, hit_record& rec) const override;
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override;
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override;
+  aabb bounding_box() const override;
+  uint32_t hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const override;
+  bool occluded(const ray& r, interval ray_interval) const override;
+  // Picks one of the objects uniformly, so the density is their average.
+  vec3 random_direction(const point3& origin) const override;
+  double pdf_value(const point3& origin, const vec3& direction) const override;
+
+private:
+  aabb bbox;
 };
 
-#endif
\ No newline at end of file
+#endif
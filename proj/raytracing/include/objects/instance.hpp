@@ -0,0 +1,43 @@
+#ifndef __INSTANCE_HPP__
+#define __INSTANCE_HPP__
+
+#include <memory>
+
+#include <objects/hittable.hpp>
+#include <objects/transform.hpp>
+
+// A placed copy of a shared object (usually a triangle_mesh or a bvh over a small
+// set of shapes): the object is stored once, and each instance only adds its
+// object-to-world transform. A bvh over instances then forms the top level of a
+// two-level acceleration structure, so thousands of copies of one asset cost one
+// asset plus a few dozen bytes each.
+//
+// Rays are moved into object space on entry and traced there against the shared
+// object. The hit reports the instance as its object and the object-space hit in
+// intersection::child, so surface_interaction can redo the work in object space
+// and bring the position and normal back to world space. Instances therefore do
+// not nest: the shared object must not itself contain instances.
+class instance: public hittable {
+public:
+  // Fails (returns nullptr) if object_to_world is not invertible. A material other
+  // than no_material replaces the object's own materials.
+  static std::shared_ptr<instance> create(std::shared_ptr<hittable> object, const affine_transform& object_to_world,
+                                          material_id mat = no_material);
+
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override;
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override;
+  aabb bounding_box() const override;
+  uint32_t hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const override;
+  bool occluded(const ray& r, interval ray_interval) const override;
+
+private:
+  instance() {}
+
+  std::shared_ptr<hittable> object;
+  affine_transform object_to_world;
+  affine_transform world_to_object;
+  material_id mat = no_material;
+  aabb bbox;
+};
+
+#endif
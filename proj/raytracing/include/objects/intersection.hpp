@@ -0,0 +1,22 @@
+#ifndef __INTERSECTION_HPP__
+#define __INTERSECTION_HPP__
+
+#include <cstdint>
+
+#include <real.hpp>
+
+class hittable;
+
+// What traversal keeps about the closest hit so far: its distance and enough to
+// rebuild the full hit_record later, once, with hittable::surface_interaction.
+// primitive tells the hit object which of its parts was hit (e.g. the sphere of
+// a sphere_set); its meaning is private to that object.
+struct intersection {
+  real t = 0;
+  const hittable* object = nullptr;
+  // Set by an instance (then object): the shape hit in the instance's object space
+  const hittable* child = nullptr;
+  uint32_t primitive = 0;
+};
+
+#endif
@@ -2,21 +2,26 @@
 #define __INTERVAL_HPP__
 
 #include <constants.hpp>
+#include <real.hpp>
 
+// Closed range of ray distances or coordinates, in the geometry scalar type
 class interval {
 public:
-  double min, max;
+  real min, max;
 
   interval(): min(INF), max(-INF) {}
-  interval(double _min, double _max): min(_min), max(_max) {}
+  interval(real _min, real _max): min(_min), max(_max) {}
+  // Tightest interval enclosing both a and b
+  interval(const interval& a, const interval& b);
 
-  double size() const;
-  bool contains(double x) const;
-  bool surrounds(double x) const;
-  double clamp(double x) const;
+  real size() const;
+  bool contains(real x) const;
+  bool surrounds(real x) const;
+  real clamp(real x) const;
+  interval expand(real delta) const;
 
   static const interval empty;
   static const interval universe;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,26 @@
+#ifndef __ONB_HPP__
+#define __ONB_HPP__
+
+#include <cmath>
+
+#include <objects/vec3.hpp>
+
+// Orthonormal basis whose w axis points along a given direction; turns directions
+// sampled around +z into world space.
+class onb {
+public:
+  vec3 u, v, w;
+
+  explicit onb(const vec3& direction) {
+    w = unit_vector(direction);
+    vec3 a = std::fabs(w.x()) > 0.9 ? vec3(0, 1, 0) : vec3(1, 0, 0);
+    v = unit_vector(cross(w, a));
+    u = cross(w, v);
+  }
+
+  vec3 transform(const vec3& local) const {
+    return local.x() * u + local.y() * v + local.z() * w;
+  }
+};
+
+#endif
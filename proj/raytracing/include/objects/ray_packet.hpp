@@ -0,0 +1,63 @@
+#ifndef __RAY_PACKET_HPP__
+#define __RAY_PACKET_HPP__
+
+#include <cstdint>
+
+#include <objects/aabb.hpp>
+#include <objects/interval.hpp>
+#include <objects/ray.hpp>
+#include <objects/vec3.hpp>
+
+#include <real.hpp>
+
+// A bundle of up to 16 coherent rays (a 4x4 block of primary rays) stored as a
+// structure of arrays so shape kernels can process several lanes per instruction.
+// Lanes hold real, so float builds fit twice as many rays in each vector.
+// Which lanes take part in a query is given by a bit mask, one bit per lane.
+//
+// finalize() derives interval bounds over all lane origins and inverse directions.
+// These bound the packet's frustum, so a single interval-arithmetic test can cull a
+// box for the whole packet before any per-lane work is done.
+class ray_packet {
+public:
+  static constexpr int size = 16;
+  static constexpr int block_width = 4;
+
+  alignas(64) real origin_x[size] = {};
+  alignas(64) real origin_y[size] = {};
+  alignas(64) real origin_z[size] = {};
+  alignas(64) real direction_x[size] = {};
+  alignas(64) real direction_y[size] = {};
+  alignas(64) real direction_z[size] = {};
+  alignas(64) real inv_direction_x[size] = {};
+  alignas(64) real inv_direction_y[size] = {};
+  alignas(64) real inv_direction_z[size] = {};
+  // Closest hit so far per lane; queries only accept hits nearer than this.
+  alignas(64) real t_max[size] = {};
+  real t_min = 0;
+  // Lanes that hold a ray at all (edge blocks may be partially filled)
+  uint32_t valid = 0;
+
+  ray_packet() {}
+
+  void set_lane(int lane, const ray& r, interval ray_interval);
+  ray lane_ray(int lane) const;
+  // Must be called after the last set_lane() and before tracing.
+  void finalize();
+
+  // True if the box is missed by every ray in the packet (conservative).
+  bool frustum_misses(const aabb& box, uint32_t active) const;
+  // Per-lane slab test; returns the subset of active lanes whose ray hits the box.
+  uint32_t hit_lanes(const aabb& box, uint32_t active) const;
+  // Sign of the first active lane's direction, used to order BVH children.
+  bool direction_negative(int axis, uint32_t active) const;
+
+private:
+  // Per-axis bounds over all valid lanes; has_frustum[axis] is false when lane
+  // directions disagree in sign along that axis and the interval test cannot help.
+  interval origin_bounds[3];
+  interval inv_direction_bounds[3];
+  bool has_frustum[3] = {false, false, false};
+};
+
+#endif
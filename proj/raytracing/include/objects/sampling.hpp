@@ -0,0 +1,105 @@
+#ifndef __SAMPLING_HPP__
+#define __SAMPLING_HPP__
+
+#include <algorithm>
+#include <cmath>
+
+#include <constants.hpp>
+
+#include <objects/vec3.hpp>
+
+// Closed-form warps from the unit square [0, 1)^2 to the domains shading needs.
+// Each takes its two uniform numbers explicitly and uses exactly those, so the
+// structure of stratified or low-discrepancy points carries over. Directions are
+// around +z; onb turns them into world space.
+
+// sin and cos of the angle 2 pi * turns. The angle is reduced to the nearest
+// quarter turn, leaving [-pi/4, pi/4] where short Taylor polynomials are good to
+// about 1e-11, and the quadrant is applied with selects instead of branches. Much
+// cheaper than std::sin and std::cos, which dominated the warps below. Needs
+// turns >= -1/8, so rounding can truncate instead of calling std::floor.
+inline void sin_cos_turns(double turns, double& sine, double& cosine) {
+  int quarters = static_cast<int>(4.0 * turns + 0.5);
+  double x = (PI / 2.0) * (4.0 * turns - quarters);
+  double x2 = x * x;
+  double s = -1.0 / 39916800;
+  s = s * x2 + 1.0 / 362880;
+  s = s * x2 - 1.0 / 5040;
+  s = s * x2 + 1.0 / 120;
+  s = s * x2 - 1.0 / 6;
+  s = (s * x2 + 1.0) * x;
+  double c = 1.0 / 479001600;
+  c = c * x2 - 1.0 / 3628800;
+  c = c * x2 + 1.0 / 40320;
+  c = c * x2 - 1.0 / 720;
+  c = c * x2 + 1.0 / 24;
+  c = c * x2 - 1.0 / 2;
+  c = c * x2 + 1.0;
+  // Quadrant q: sin = s, c, -s, -c and cos = c, -s, -c, s
+  int q = quarters & 3;
+  double swapped_s = (q & 1) ? c : s;
+  double swapped_c = (q & 1) ? s : c;
+  sine = (q & 2) ? -swapped_s : swapped_s;
+  cosine = ((q + 1) & 2) ? -swapped_c : swapped_c;
+}
+
+// A warped point or direction with its density (per unit area on the disk, per
+// steradian for directions)
+struct warped_sample {
+  vec3 value;
+  double pdf;
+};
+
+// Shirley and Chiu's concentric map onto the unit disk in the z = 0 plane
+inline warped_sample sample_concentric_disk(double u1, double u2) {
+  double a = 2.0 * u1 - 1.0;
+  double b = 2.0 * u2 - 1.0;
+  // Concentric squares map to circles; the angle is measured in turns. Written
+  // as selects, since which wedge a sample falls in is a coin flip.
+  bool a_major = std::abs(a) > std::abs(b);
+  double radius = a_major ? a : b;
+  double ratio = radius != 0 ? (a_major ? b : a) / radius : 0.0;
+  double turns = a_major ? ratio / 8.0 : 0.25 - ratio / 8.0;
+  double sine, cosine;
+  sin_cos_turns(turns, sine, cosine);
+  return {vec3(radius * cosine, radius * sine, 0), 1.0 / PI};
+}
+
+inline double cosine_hemisphere_pdf(double cos_theta) {
+  return cos_theta > 0 ? cos_theta / PI : 0.0;
+}
+
+// Density cos(theta) / pi: a concentric disk sample lifted onto the hemisphere
+// (Malley's method)
+inline warped_sample sample_cosine_hemisphere(double u1, double u2) {
+  vec3 disk = sample_concentric_disk(u1, u2).value;
+  double z = std::sqrt(std::max(0.0, 1.0 - disk.x() * disk.x() - disk.y() * disk.y()));
+  return {vec3(disk.x(), disk.y(), z), cosine_hemisphere_pdf(z)};
+}
+
+inline double uniform_sphere_pdf() {
+  return 1.0 / (4.0 * PI);
+}
+
+inline warped_sample sample_uniform_sphere(double u1, double u2) {
+  double z = 1.0 - 2.0 * u1;
+  double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+  double sine, cosine;
+  sin_cos_turns(u2, sine, cosine);
+  return {vec3(r * cosine, r * sine, z), uniform_sphere_pdf()};
+}
+
+inline double uniform_cone_pdf(double cos_theta_max) {
+  return 1.0 / (2.0 * PI * (1.0 - cos_theta_max));
+}
+
+// Uniform in solid angle over the directions within acos(cos_theta_max) of +z
+inline warped_sample sample_uniform_cone(double u1, double u2, double cos_theta_max) {
+  double z = 1.0 + u1 * (cos_theta_max - 1.0);
+  double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+  double sine, cosine;
+  sin_cos_turns(u2, sine, cosine);
+  return {vec3(r * cosine, r * sine, z), uniform_cone_pdf(cos_theta_max)};
+}
+
+#endif
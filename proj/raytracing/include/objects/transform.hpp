@@ -0,0 +1,56 @@
+#ifndef __TRANSFORM_HPP__
+#define __TRANSFORM_HPP__
+
+#include <objects/aabb.hpp>
+#include <objects/ray.hpp>
+#include <objects/vec3.hpp>
+
+// Affine map x -> A x + b, kept as the 3x4 matrix [A | b] in row-major order.
+// Composition reads like function application: (a * b) applies b first.
+class affine_transform {
+public:
+  double m[3][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};
+
+  affine_transform() {}
+
+  static affine_transform translation(const vec3& offset);
+  static affine_transform scaling(const vec3& factors);
+  // Counter-clockwise rotation about axis (seen looking down the axis), in degrees
+  static affine_transform rotation(const vec3& axis, double degrees);
+
+  friend affine_transform operator*(const affine_transform& a, const affine_transform& b);
+
+  point3 apply_point(const point3& p) const {
+    return point3(m[0][0] * p[0] + m[0][1] * p[1] + m[0][2] * p[2] + m[0][3],
+                  m[1][0] * p[0] + m[1][1] * p[1] + m[1][2] * p[2] + m[1][3],
+                  m[2][0] * p[0] + m[2][1] * p[1] + m[2][2] * p[2] + m[2][3]);
+  }
+
+  vec3 apply_vector(const vec3& v) const {
+    return vec3(m[0][0] * v[0] + m[0][1] * v[1] + m[0][2] * v[2],
+                m[1][0] * v[0] + m[1][1] * v[1] + m[1][2] * v[2],
+                m[2][0] * v[0] + m[2][1] * v[1] + m[2][2] * v[2]);
+  }
+
+  // A^T v. Normals map with the inverse transpose, so a normal goes to world
+  // space as world_to_object.apply_transposed(n).
+  vec3 apply_transposed(const vec3& v) const {
+    return vec3(m[0][0] * v[0] + m[1][0] * v[1] + m[2][0] * v[2],
+                m[0][1] * v[0] + m[1][1] * v[1] + m[2][1] * v[2],
+                m[0][2] * v[0] + m[1][2] * v[1] + m[2][2] * v[2]);
+  }
+
+  // The direction is not renormalized, so distances along the ray are the same
+  // before and after.
+  ray apply_ray(const ray& r) const {
+    return ray(apply_point(r.origin()), apply_vector(r.direction()));
+  }
+
+  // Box around the eight transformed corners; unbounded boxes stay unbounded.
+  aabb apply_box(const aabb& box) const;
+
+  // False if A is singular (e.g. a zero scale)
+  bool invert(affine_transform& inverse) const;
+};
+
+#endif
@@ -1,48 +1,130 @@
 #ifndef __VEC3_HPP__
 #define __VEC3_HPP__
 
+#include <cmath>
 #include <iostream>
 
-class vec3 {
+#include <randomizer.hpp>
+#include <real.hpp>
+
+// Three-component vector of T, header-only so every operator inlines into the
+// intersection and shading loops. The free functions are hidden friends: they are
+// found by argument-dependent lookup and, not being templates themselves, accept
+// any scalar convertible to T (2 * v, 0.5 * v).
+template <typename T>
+class basic_vec3 {
 public:
-  double e[3];
+  using value_type = T;
+
+  T e[3];
+
+  constexpr basic_vec3(): e{0, 0, 0} {}
+  constexpr basic_vec3(T _e0, T _e1, T _e2): e{_e0, _e1, _e2} {}
+  template <typename U>
+  constexpr explicit basic_vec3(const basic_vec3<U>& v)
+    : e{static_cast<T>(v.x()), static_cast<T>(v.y()), static_cast<T>(v.z())} {}
+
+  constexpr T x() const { return e[0]; }
+  constexpr T y() const { return e[1]; }
+  constexpr T z() const { return e[2]; }
+
+  constexpr basic_vec3 operator-() const { return basic_vec3(-e[0], -e[1], -e[2]); }
+  constexpr T operator[](int i) const { return e[i]; }
+  constexpr T& operator[](int i) { return e[i]; }
+
+  constexpr basic_vec3& operator+=(const basic_vec3& v) {
+    e[0] += v.e[0];
+    e[1] += v.e[1];
+    e[2] += v.e[2];
+    return *this;
+  }
+
+  constexpr basic_vec3& operator*=(T t) {
+    e[0] *= t;
+    e[1] *= t;
+    e[2] *= t;
+    return *this;
+  }
+
+  constexpr basic_vec3& operator/=(T t) {
+    return *this *= 1 / t;
+  }
+
+  T length() const { return std::sqrt(length_squared()); }
+  constexpr T length_squared() const { return e[0] * e[0] + e[1] * e[1] + e[2] * e[2]; }
 
-  vec3(): e{0, 0, 0} {}
-  vec3(double _e0, double _e1, double _e2): e{_e0, _e1, _e2} {}
+  bool near_zero() const {
+    const T s = static_cast<T>(1e-8);
+    return (std::abs(e[0]) < s) && (std::abs(e[1]) < s) && (std::abs(e[2]) < s);
+  }
 
-  double x() const;
-  double y() const;
-  double z() const;
+  static basic_vec3 random() {
+    double u[3];
+    thread_rng().fill(u, 3);
+    return basic_vec3(static_cast<T>(u[0]), static_cast<T>(u[1]), static_cast<T>(u[2]));
+  }
 
-  vec3 operator-() const;
-  double operator[](int i) const;
-  double &operator[](int i);
+  static basic_vec3 random(T min, T max) {
+    double u[3];
+    thread_rng().fill(u, 3);
+    return basic_vec3(static_cast<T>(min + (max - min) * u[0]), static_cast<T>(min + (max - min) * u[1]),
+                      static_cast<T>(min + (max - min) * u[2]));
+  }
 
-  vec3 &operator+=(const vec3& v);
-  vec3 &operator*=(const double t);
-  vec3 &operator/=(const double t);
+  friend std::ostream& operator<<(std::ostream& out, const basic_vec3& v) {
+    return out << "(" << v.e[0] << ", " << v.e[1] << ", " << v.e[2] << ")";
+  }
 
-  double length() const;
-  double length_squared() const;
-  bool near_zero() const;
-  
-  static vec3 random();
-  static vec3 random(double min, double max);
+  friend constexpr basic_vec3 operator+(const basic_vec3& u, const basic_vec3& v) {
+    return basic_vec3(u.e[0] + v.e[0], u.e[1] + v.e[1], u.e[2] + v.e[2]);
+  }
+
+  friend constexpr basic_vec3 operator-(const basic_vec3& u, const basic_vec3& v) {
+    return basic_vec3(u.e[0] - v.e[0], u.e[1] - v.e[1], u.e[2] - v.e[2]);
+  }
+
+  friend constexpr basic_vec3 operator*(const basic_vec3& u, const basic_vec3& v) {
+    return basic_vec3(u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]);
+  }
+
+  friend constexpr basic_vec3 operator*(T t, const basic_vec3& v) {
+    return basic_vec3(t * v.e[0], t * v.e[1], t * v.e[2]);
+  }
+
+  friend constexpr basic_vec3 operator*(const basic_vec3& v, T t) {
+    return t * v;
+  }
+
+  friend constexpr basic_vec3 operator/(const basic_vec3& v, T t) {
+    return (1 / t) * v;
+  }
+
+  friend constexpr T dot(const basic_vec3& u, const basic_vec3& v) {
+    return u.e[0] * v.e[0] + u.e[1] * v.e[1] + u.e[2] * v.e[2];
+  }
+
+  friend constexpr basic_vec3 cross(const basic_vec3& u, const basic_vec3& v) {
+    return basic_vec3(
+      u.e[1] * v.e[2] - u.e[2] * v.e[1],
+      u.e[2] * v.e[0] - u.e[0] * v.e[2],
+      u.e[0] * v.e[1] - u.e[1] * v.e[0]
+    );
+  }
+
+  friend basic_vec3 unit_vector(const basic_vec3& v) {
+    T len = v.length();
+    if (len == 0) {
+      return v;
+    }
+    return v / len;
+  }
 };
 
-std::ostream& operator<<(std::ostream& out, const vec3& v);
-vec3 operator+(const vec3& u, const vec3& v);
-vec3 operator-(const vec3& u, const vec3& v);
-vec3 operator*(const vec3& u, const vec3& v);
-vec3 operator*(double t, const vec3& v);
-vec3 operator*(const vec3& v, double t);
-vec3 operator/(vec3 v, double t);
-double dot(const vec3& u, const vec3& v);
-vec3 cross(const vec3& u, const vec3& v);
-vec3 unit_vector(vec3 v);
+#if defined(RAYTRACING_SIMD_VEC3) && defined(__SSE4_1__)
+#include <objects/vec3_sse.hpp>
+#endif
 
+using vec3 = basic_vec3<real>;
 using point3 = vec3;
 
-vec3 random_unit_vector();
-
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,121 @@
+#ifndef __VEC3_SSE_HPP__
+#define __VEC3_SSE_HPP__
+
+#include <smmintrin.h>
+
+// basic_vec3<float> held in one 16-byte SSE register's worth of memory, so each
+// operator is a single packed instruction. The fourth lane is padding: it starts
+// at zero and is never read back through x()/y()/z() or dot().
+// Included from vec3.hpp when RAYTRACING_SIMD_VEC3 is set and SSE4.1 is available.
+template <>
+class basic_vec3<float> {
+public:
+  using value_type = float;
+
+  alignas(16) float e[4];
+
+  basic_vec3(): e{0, 0, 0, 0} {}
+  basic_vec3(float _e0, float _e1, float _e2): e{_e0, _e1, _e2, 0} {}
+  template <typename U>
+  explicit basic_vec3(const basic_vec3<U>& v)
+    : e{static_cast<float>(v.x()), static_cast<float>(v.y()), static_cast<float>(v.z()), 0} {}
+
+  float x() const { return e[0]; }
+  float y() const { return e[1]; }
+  float z() const { return e[2]; }
+
+  basic_vec3 operator-() const { return basic_vec3(_mm_sub_ps(_mm_setzero_ps(), load())); }
+  float operator[](int i) const { return e[i]; }
+  float& operator[](int i) { return e[i]; }
+
+  basic_vec3& operator+=(const basic_vec3& v) {
+    _mm_store_ps(e, _mm_add_ps(load(), v.load()));
+    return *this;
+  }
+
+  basic_vec3& operator*=(float t) {
+    _mm_store_ps(e, _mm_mul_ps(load(), _mm_set1_ps(t)));
+    return *this;
+  }
+
+  basic_vec3& operator/=(float t) {
+    return *this *= 1 / t;
+  }
+
+  float length() const { return std::sqrt(length_squared()); }
+  float length_squared() const { return dot(*this, *this); }
+
+  bool near_zero() const {
+    const __m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), load());
+    return (_mm_movemask_ps(_mm_cmplt_ps(magnitude, _mm_set1_ps(1e-8f))) & 0x7) == 0x7;
+  }
+
+  static basic_vec3 random() {
+    double u[3];
+    thread_rng().fill(u, 3);
+    return basic_vec3(static_cast<float>(u[0]), static_cast<float>(u[1]), static_cast<float>(u[2]));
+  }
+
+  static basic_vec3 random(float min, float max) {
+    double u[3];
+    thread_rng().fill(u, 3);
+    return basic_vec3(static_cast<float>(min + (max - min) * u[0]), static_cast<float>(min + (max - min) * u[1]),
+                      static_cast<float>(min + (max - min) * u[2]));
+  }
+
+  friend std::ostream& operator<<(std::ostream& out, const basic_vec3& v) {
+    return out << "(" << v.e[0] << ", " << v.e[1] << ", " << v.e[2] << ")";
+  }
+
+  friend basic_vec3 operator+(const basic_vec3& u, const basic_vec3& v) {
+    return basic_vec3(_mm_add_ps(u.load(), v.load()));
+  }
+
+  friend basic_vec3 operator-(const basic_vec3& u, const basic_vec3& v) {
+    return basic_vec3(_mm_sub_ps(u.load(), v.load()));
+  }
+
+  friend basic_vec3 operator*(const basic_vec3& u, const basic_vec3& v) {
+    return basic_vec3(_mm_mul_ps(u.load(), v.load()));
+  }
+
+  friend basic_vec3 operator*(float t, const basic_vec3& v) {
+    return basic_vec3(_mm_mul_ps(_mm_set1_ps(t), v.load()));
+  }
+
+  friend basic_vec3 operator*(const basic_vec3& v, float t) {
+    return t * v;
+  }
+
+  friend basic_vec3 operator/(const basic_vec3& v, float t) {
+    return (1 / t) * v;
+  }
+
+  friend float dot(const basic_vec3& u, const basic_vec3& v) {
+    // Multiply lanes 0-2, sum them into lane 0
+    return _mm_cvtss_f32(_mm_dp_ps(u.load(), v.load(), 0x71));
+  }
+
+  friend basic_vec3 cross(const basic_vec3& u, const basic_vec3& v) {
+    const __m128 a = u.load();
+    const __m128 b = v.load();
+    const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return basic_vec3(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+  }
+
+  friend basic_vec3 unit_vector(const basic_vec3& v) {
+    float len = v.length();
+    if (len == 0) {
+      return v;
+    }
+    return v / len;
+  }
+
+private:
+  explicit basic_vec3(__m128 v) { _mm_store_ps(e, v); }
+  __m128 load() const { return _mm_load_ps(e); }
+};
+
+#endif
@@ -1,18 +1,109 @@
 #ifndef __RANDOMIZER_HPP__
 #define __RANDOMIZER_HPP__
 
-#include <random>
+#include <cstdint>
+
+#include <render/sampler.hpp>
+
+// Counter-based random numbers: every value is a pure function of
+// (seed, pixel, sample index, bounce, dimension), so a fixed seed gives the same
+// image no matter how many threads render it or which thread gets which tile.
+//
+// A stream is keyed by (seed, pixel, sample); each value hashes the key with a
+// counter made of the bounce and a running dimension index. The hash feeds a
+// Weyl sequence through the PCG RXS-M-XS output permutation. A stream started
+// with a sampler takes its values from that sampler instead.
+class rng_stream {
+public:
+  rng_stream() {}
+
+  // Starts the stream for one camera sample; resets bounce and dimension to 0.
+  // pattern, if given, must outlive the sample.
+  void start(uint64_t seed, uint64_t pixel, uint64_t sample, const sampler* pattern = nullptr) {
+    key = mix(mix(seed ^ 0x5851f42d4c957f2dull) ^ pixel) ^ (sample * 0x9e3779b97f4a7c15ull);
+    key = mix(key) | 1;
+    bounce = 0;
+    dimension = 0;
+    source = pattern;
+    stream_seed = seed;
+    stream_pixel = pixel;
+    stream_sample = static_cast<uint32_t>(sample);
+  }
+
+  // Moves to path vertex b (0 is the camera ray); dimensions restart at 0.
+  void set_bounce(uint32_t b) {
+    bounce = b;
+    dimension = 0;
+  }
+
+  double next() {
+    const uint32_t d = dimension++;
+    return source ? source->value(stream_seed, stream_pixel, stream_sample, bounce, d) : to_unit(value(bounce, d));
+  }
+
+  // Batch form of next(): fills out[0..count) with the next count dimensions.
+  // Without a sampler the loop has no carried dependency, so it vectorizes.
+  void fill(double* out, int count) {
+    if (source) {
+      for (int k = 0; k < count; ++k) {
+        out[k] = next();
+      }
+      return;
+    }
+    const uint32_t first = dimension;
+    for (int k = 0; k < count; ++k) {
+      out[k] = to_unit(value(bounce, first + static_cast<uint32_t>(k)));
+    }
+    dimension += static_cast<uint32_t>(count);
+  }
+
+private:
+  uint64_t key = 1;
+  uint32_t bounce = 0;
+  uint32_t dimension = 0;
+  // Set while a sampler supplies the values, with the sample it was started for
+  const sampler* source = nullptr;
+  uint64_t stream_seed = 0;
+  uint64_t stream_pixel = 0;
+  uint32_t stream_sample = 0;
+
+  uint64_t value(uint32_t b, uint32_t d) const {
+    uint64_t counter = (static_cast<uint64_t>(b) << 32) | d;
+    return permute(key * (counter + 1) + counter * 0xda942042e4dd58b5ull);
+  }
+
+  // PCG RXS-M-XS 64-bit output permutation
+  static uint64_t permute(uint64_t state) {
+    uint64_t word = ((state >> ((state >> 59u) + 5u)) ^ state) * 12605985483714917081ull;
+    return (word >> 43u) ^ word;
+  }
+
+  // SplitMix64 finalizer, used to turn key components into a well-mixed key
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  // Top 53 bits as a double in [0, 1)
+  static double to_unit(uint64_t x) {
+    return static_cast<double>(x >> 11) * 0x1.0p-53;
+  }
+};
+
+// The calling thread's stream. The render loop starts it for every camera sample,
+// so code that just calls random_double() stays deterministic.
+inline rng_stream& thread_rng() {
+  thread_local rng_stream stream;
+  return stream;
+}
 
 inline double random_double() {
-  // Thread-local PRNG to allow safe parallel rendering without contention.
-  // Each thread gets its own generator seeded from std::random_device.
-  thread_local std::mt19937 generator(std::random_device{}());
-  thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
-  return distribution(generator);
+  return thread_rng().next();
 }
 
 inline double random_double(double min, double max) {
   return min + (max - min) * random_double();
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,12 @@
+#ifndef __REAL_HPP__
+#define __REAL_HPP__
+
+// Scalar type of the geometry and shading math. Float builds (RAYTRACING_FLOAT)
+// trade precision for throughput and memory; double is the reference.
+#ifdef RAYTRACING_FLOAT
+using real = float;
+#else
+using real = double;
+#endif
+
+#endif
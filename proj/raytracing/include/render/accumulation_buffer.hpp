@@ -0,0 +1,97 @@
+#ifndef __ACCUMULATION_BUFFER_HPP__
+#define __ACCUMULATION_BUFFER_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <objects/color.hpp>
+
+#include <render/tile_scheduler.hpp>
+
+// One run's share of a buffer's samples: sample numbers [first_sample,
+// end_sample) of the streams of seed, in the tiles that part tile_part of
+// tile_part_count gets at tile_size (see tile_scheduler).
+struct sample_stream {
+  uint64_t seed = 0;
+  uint32_t first_sample = 0;
+  uint32_t end_sample = 0;
+  int32_t tile_size = 0;
+  int32_t tile_part = 0;
+  int32_t tile_part_count = 1;
+
+  // Same seed, intersecting sample ranges and a tile in common: the two hold
+  // copies of the same samples. Parts of different tile sizes are assumed to
+  // share pixels.
+  bool overlaps(const sample_stream& other) const;
+};
+
+// Per-pixel running sums of radiance samples and how many samples went into them.
+// Keeping sums rather than averages lets progressive passes, resumed runs and
+// extra samples all be added without redoing finished work. The sum of squared
+// sample luminance gives each pixel's variance for adaptive sampling.
+//
+// Checkpoints are a small header followed by the raw arrays:
+//   "RTCK" | version u32 | width i32 | height i32 | fingerprint u64 | seed u64
+//   | stream count u32 | streams: seed u64, first_sample u32, end_sample u32,
+//     tile_size i32, tile_part i32, tile_part_count i32, padding u32
+//   | sum: width*height*3 f64 | luminance_sq_sum: width*height f64
+//   | sample_count: width*height u32
+// The fingerprint identifies the scene and camera setup, so a checkpoint of a
+// different scene or view is never mistaken for a resumable one; resuming also
+// needs the same seed. The same files serve as the partial
+// buffers of distributed renders: since they hold sums and counts, buffers of
+// different tiles or of different seeds merge by plain addition. The streams
+// record which samples went in, so merging the same samples twice is caught.
+class accumulation_buffer {
+public:
+  int width = 0;
+  int height = 0;
+  // Double even in float builds: sums add up thousands of samples and are what
+  // checkpoints store.
+  std::vector<basic_vec3<double>> sum;
+  std::vector<double> luminance_sq_sum;
+  std::vector<uint32_t> sample_count;
+  // Seed of the random streams the samples were drawn from
+  uint64_t seed = 0;
+  // Every run whose samples were added in
+  std::vector<sample_stream> streams;
+
+  accumulation_buffer() {}
+  accumulation_buffer(int _width, int _height);
+
+  // Resizes to width x height and clears every pixel
+  void reset(int _width, int _height);
+  // Accumulates one radiance sample into pixel index
+  void add_sample(int index, const color& sample);
+  // Adds a tile-sized buffer (rendered for tile t) into this full-image buffer
+  void merge_tile(const tile& t, const accumulation_buffer& local);
+  // Adds a buffer of the same size, pixel by pixel, and takes over its streams
+  void merge(const accumulation_buffer& other);
+  // Notes that run's samples are in the buffer, extending the stream of an
+  // earlier run that it continues.
+  void record_stream(const sample_stream& run);
+
+  // Average of the accumulated samples, black where no sample landed yet
+  color resolve(int index) const;
+  uint32_t min_samples() const;
+  uint32_t max_samples() const;
+  // Half-width of the 95% confidence interval of the pixel's mean, measured on
+  // the gamma-corrected display value; INF until the pixel has two samples.
+  double noise_estimate(int index) const;
+  // Variance of the pixel's mean luminance (sample variance / n); INF until the
+  // pixel has two samples.
+  double mean_variance(int index) const;
+
+  // Writes atomically (temporary file + rename), so a process killed mid-write
+  // leaves the previous checkpoint intact.
+  bool save(const std::string& path, uint64_t fingerprint) const;
+  // Replaces the contents and streams if path holds a checkpoint of the same
+  // size, fingerprint and seed; returns false and leaves the buffer untouched otherwise.
+  bool load(const std::string& path, uint64_t fingerprint);
+  // Replaces the contents with any checkpoint, taking over its size, seed and streams, and
+  // reports the fingerprint it was saved with.
+  bool read(const std::string& path, uint64_t& fingerprint);
+};
+
+#endif
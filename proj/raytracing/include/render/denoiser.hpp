@@ -0,0 +1,54 @@
+#ifndef __DENOISER_HPP__
+#define __DENOISER_HPP__
+
+#include <functional>
+#include <vector>
+
+#include <objects/color.hpp>
+#include <objects/vec3.hpp>
+
+// Auxiliary buffers (AOVs) describing the first surface seen through each pixel,
+// averaged over a few jittered camera rays. Row-major, top row first.
+struct aov_buffer {
+  int width = 0;
+  int height = 0;
+  // Material colour; the sky colour where rays escape
+  std::vector<color> albedo;
+  // Shading normal facing the camera; zero where rays escape. Averaging shortens
+  // the normal of pixels that straddle an edge.
+  std::vector<vec3> normal;
+  // Distance from the camera; 0 where rays escape
+  std::vector<double> depth;
+
+  // Resizes to width x height and clears every pixel
+  void reset(int _width, int _height);
+};
+
+// Edge-aware a-trous wavelet filter after SVGF (Schied et al. 2017), without the
+// temporal part. Radiance is divided by albedo first, so only lighting is blurred
+// and texture and colour edges come back sharp. Each iteration applies a 5x5
+// B3-spline kernel with taps spread 2^iteration pixels apart; a tap's weight falls
+// off with the difference in depth and normal, and with the difference in
+// luminance measured against the pixel's noise level, so converged pixels and
+// geometric edges are left alone.
+class denoiser {
+public:
+  int iterations = 5;
+  // Luminance differences are scaled by this many standard deviations of noise
+  double sigma_luminance = 4.0;
+  // Normal weight exp(-sigma_normal * (1 - cos)), close to cos^sigma_normal
+  double sigma_normal = 128.0;
+  // Depth differences relative to depth, per pixel of tap distance
+  double sigma_depth = 0.02;
+  int thread_count = 1;
+
+  // Filters image (linear radiance) in place. variance holds the variance of each
+  // pixel's mean luminance; INF marks pixels with too few samples to tell.
+  void apply(std::vector<color>& image, const std::vector<double>& variance, const aov_buffer& aovs) const;
+
+private:
+  // Calls fn(first_row, end_row) for disjoint row ranges covering [0, height)
+  void parallel_rows(int height, const std::function<void(int, int)>& fn) const;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef __PATH_QUEUE_HPP__
+#define __PATH_QUEUE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <aligned_allocator.hpp>
+#include <objects/color.hpp>
+#include <objects/hit_record.hpp>
+#include <objects/ray.hpp>
+
+// Paths in flight in the wavefront integrator, stored as structure of arrays so
+// each stage streams through only the fields it needs. Slot k of every array
+// belongs to the same path.
+class path_queue {
+public:
+  aligned_vector<double> origin_x, origin_y, origin_z;
+  aligned_vector<double> direction_x, direction_y, direction_z;
+  aligned_vector<double> throughput_r, throughput_g, throughput_b;
+  // Light gathered so far, added to the pixel when the path ends
+  aligned_vector<double> radiance_r, radiance_g, radiance_b;
+  // Density of the BSDF sample that produced the current ray (0: camera ray or
+  // specular bounce), for weighting the emitter it may hit
+  std::vector<double> scatter_pdf;
+  // Tile-local pixel the path's sample is added to
+  std::vector<int> local_pixel;
+  // Image-space pixel and sample number, which key the path's random stream
+  std::vector<uint32_t> image_pixel;
+  std::vector<uint32_t> sample;
+  // Rays traced so far before the current one (0 for camera rays)
+  std::vector<uint32_t> bounce;
+  // Filled by the intersection stage for paths that hit something
+  std::vector<hit_record> rec;
+
+  size_t size() const { return count; }
+  void reserve(size_t capacity);
+  void clear() { count = 0; }
+
+  // Appends a path and returns its slot
+  size_t push(const ray& r, const color& throughput, const color& radiance, double pdf, int local, uint32_t pixel,
+              uint32_t sample_index, uint32_t bounces);
+  ray path_ray(size_t slot) const;
+  color path_throughput(size_t slot) const;
+  color path_radiance(size_t slot) const;
+
+private:
+  size_t count = 0;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef __RENDER_STATS_HPP__
+#define __RENDER_STATS_HPP__
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Render statistics: ray and intersection counts, BVH work, how paths end and how
+// long they are, and per-thread busy/idle time. Each render worker counts into its
+// own cache-line-aligned thread_stats, found through a thread-local pointer, and
+// the slots are only added up when the render is done.
+//
+// Counting is compiled in only with RAYTRACING_STATS defined (CMake option of the
+// same name). Otherwise the RT_STAT_* macros expand to nothing and the hot paths
+// carry no counter code at all.
+enum class stat_counter : int {
+  primary_rays,
+  secondary_rays,
+  shadow_rays,
+  bvh_nodes_visited,
+  sphere_tests,
+  box_tests,
+  plane_tests,
+  quad_tests,
+  triangle_tests,
+  instance_tests,
+  paths_escaped,
+  paths_max_depth,
+  paths_absorbed,
+  paths_roulette,
+  count
+};
+
+struct alignas(64) thread_stats {
+  // Paths of this many rays or more share the last histogram bucket
+  static constexpr int max_path_length = 64;
+
+  uint64_t counters[static_cast<int>(stat_counter::count)] = {};
+  // path_length[n]: paths that traced n rays (camera ray included)
+  uint64_t path_length[max_path_length + 1] = {};
+  uint64_t tiles = 0;
+  double busy_seconds = 0;
+  double idle_seconds = 0;
+
+  void add(const thread_stats& other);
+};
+
+class render_stats {
+public:
+  // Clears the counts and makes one slot per worker thread
+  void reset(int worker_count);
+  thread_stats& worker(int id) { return workers[id]; }
+  // Sum over all workers
+  thread_stats total() const;
+
+  // Human-readable summary
+  void print(std::ostream& out) const;
+  bool write_json(const std::string& path) const;
+
+  // Directs the calling thread's counts to slot; nullptr stops counting.
+  static void attach(thread_stats* slot) { current() = slot; }
+
+  static void add(stat_counter counter, uint64_t n) {
+    if (thread_stats* slot = current()) slot->counters[static_cast<int>(counter)] += n;
+  }
+
+  static void end_path(stat_counter outcome, int length) {
+    if (thread_stats* slot = current()) {
+      slot->counters[static_cast<int>(outcome)] += 1;
+      slot->path_length[length < thread_stats::max_path_length ? length : thread_stats::max_path_length] += 1;
+    }
+  }
+
+  static bool enabled() {
+#ifdef RAYTRACING_STATS
+    return true;
+#else
+    return false;
+#endif
+  }
+
+private:
+  std::vector<thread_stats> workers;
+
+  static thread_stats*& current() {
+    thread_local thread_stats* slot = nullptr;
+    return slot;
+  }
+};
+
+#ifdef RAYTRACING_STATS
+#define RT_STAT_ADD(counter, n) render_stats::add(stat_counter::counter, (n))
+#define RT_STAT_INC(counter) render_stats::add(stat_counter::counter, 1)
+#define RT_STAT_END_PATH(outcome, length) render_stats::end_path(stat_counter::outcome, (length))
+#else
+#define RT_STAT_ADD(counter, n) ((void)0)
+#define RT_STAT_INC(counter) ((void)0)
+#define RT_STAT_END_PATH(outcome, length) ((void)0)
+#endif
+
+#endif
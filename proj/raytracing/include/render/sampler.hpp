@@ -0,0 +1,51 @@
+#ifndef __SAMPLER_HPP__
+#define __SAMPLER_HPP__
+
+#include <cstdint>
+#include <string>
+
+// How the dimensions of a camera sample are chosen:
+//   independent  every value is an independent uniform random number
+//   stratified   jittered strata: the samples of a pixel cover a grid of
+//                about samples_per_pixel cells, one random point per cell
+//   sobol        Owen-scrambled Sobol points, shuffled per pixel
+//   blue_noise   one Owen-scrambled Sobol sequence for the whole image,
+//                toroidally shifted per pixel by a blue-noise mask, so the
+//                remaining error looks like fine-grained noise on screen
+enum class sampler_kind : uint8_t {
+  independent,
+  stratified,
+  sobol,
+  blue_noise
+};
+
+// Values for the non-independent sampler kinds. Dimensions are consumed in pairs:
+// dimensions 2k and 2k + 1 of a path vertex are the two coordinates of one 2D
+// point set (pixel position, lens position, a bounce direction...), and every
+// pair gets its own scrambling, so pairs never correlate with each other. Like
+// rng_stream, a value is a pure function of (seed, pixel, sample, bounce,
+// dimension).
+class sampler {
+public:
+  sampler() {}
+  // samples_per_pixel sizes the strata of the stratified kind; samples past it
+  // start a new, independently permuted set of strata.
+  sampler(sampler_kind kind, int samples_per_pixel, int image_width);
+
+  sampler_kind kind() const { return pattern; }
+  double value(uint64_t seed, uint64_t pixel, uint32_t sample, uint32_t bounce, uint32_t dimension) const;
+
+  // Parses independent, stratified, sobol or bluenoise.
+  static bool parse(const std::string& name, sampler_kind& kind);
+
+private:
+  sampler_kind pattern = sampler_kind::independent;
+  uint32_t strata_x = 1;
+  uint32_t strata_y = 1;
+  uint32_t width = 1;
+
+  double stratified(uint32_t scramble, uint32_t sample, uint32_t axis) const;
+  double blue_noise(uint32_t scramble, uint64_t pixel, uint32_t sample, uint32_t axis) const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef __TILE_SCHEDULER_HPP__
+#define __TILE_SCHEDULER_HPP__
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Half-open pixel rectangle [x0, x1) x [y0, y1)
+struct tile {
+  int x0, y0, x1, y1;
+
+  int width() const { return x1 - x0; }
+  int height() const { return y1 - y0; }
+  int pixel_count() const { return width() * height(); }
+};
+
+// Splits the image into square tiles, orders them along a Morton (Z-order) curve
+// and deals contiguous runs of that order to per-thread deques. A thread pops
+// from the front of its own deque and, once it runs dry, steals from the back of
+// another thread's deque, so expensive regions of the image get shared out
+// while each thread keeps working on spatially close tiles.
+//
+// For rendering one frame in several processes, part / part_count keeps only
+// every part_count-th tile of the Z-order, starting at tile number part. Dealing
+// tiles round-robin gives every process a share of each region of the image, so
+// processes finish at about the same time.
+class tile_scheduler {
+public:
+  tile_scheduler(int image_width, int image_height, int tile_size, int thread_count, int part = 0,
+                 int part_count = 1);
+
+  // Fetches the next tile for thread_id; returns false once all tiles are taken.
+  bool next(int thread_id, tile& out);
+  size_t tile_count() const;
+  // Pixels covered by this scheduler's tiles
+  size_t pixel_count() const;
+
+private:
+  // Each queue sits on its own cache line so threads polling their own queue
+  // do not invalidate their neighbours' lines.
+  struct alignas(64) worker_queue {
+    std::mutex lock;
+    std::deque<tile> tiles;
+  };
+
+  std::vector<worker_queue> queues;
+  size_t total_tiles = 0;
+  size_t total_pixels = 0;
+
+  bool steal(int thief_id, tile& out);
+};
+
+#endif
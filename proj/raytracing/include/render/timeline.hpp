@@ -0,0 +1,71 @@
+#ifndef __TIMELINE_HPP__
+#define __TIMELINE_HPP__
+
+#include <cstdint>
+#include <string>
+
+#include <render/tile_scheduler.hpp>
+
+// Timeline of a run (scene load, BVH builds, tiles per worker, progress updates,
+// image encoding) written as Chrome trace JSON, viewable in chrome://tracing or
+// ui.perfetto.dev.
+//
+// Each thread appends finished spans to its own buffer without locking; a lock is
+// only taken the first time a thread names itself. Buffers are keyed by thread
+// name, so "worker 3" stays one row of the timeline across the threads that
+// successive render passes start. write() must run once those threads are joined.
+//
+// Recording is off until start(); until then spans cost one flag test.
+class timeline {
+public:
+  // Enables recording; timestamps count from this call.
+  static void start();
+  static bool enabled() { return active; }
+  // Row the calling thread's spans go to
+  static void name_thread(const std::string& name);
+  static bool write(const std::string& path);
+
+  static int64_t now_ns();
+
+  enum class detail : uint8_t { none, tile, index };
+  // name and category must be string literals (only the pointers are kept)
+  static void record(const char* name, const char* category, int64_t begin_ns, int64_t end_ns, detail kind,
+                     const int32_t* values);
+
+private:
+  static bool active;
+};
+
+// Records the enclosing scope as a span
+class trace_span {
+public:
+  trace_span(const char* _name, const char* _category): name(_name), category(_category) {
+    if (timeline::enabled()) begin = timeline::now_ns();
+  }
+  trace_span(const char* _name, const char* _category, const tile& t): trace_span(_name, _category) {
+    kind = timeline::detail::tile;
+    values[0] = t.x0;
+    values[1] = t.y0;
+    values[2] = t.x1;
+    values[3] = t.y1;
+  }
+  trace_span(const char* _name, const char* _category, int index): trace_span(_name, _category) {
+    kind = timeline::detail::index;
+    values[0] = index;
+  }
+  ~trace_span() {
+    if (timeline::enabled()) timeline::record(name, category, begin, timeline::now_ns(), kind, values);
+  }
+
+  trace_span(const trace_span&) = delete;
+  trace_span& operator=(const trace_span&) = delete;
+
+private:
+  const char* name;
+  const char* category;
+  int64_t begin = 0;
+  timeline::detail kind = timeline::detail::none;
+  int32_t values[4] = {};
+};
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef __SCENE_HPP__
+#define __SCENE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <objects/camera.hpp>
+#include <objects/hittable.hpp>
+
+#include <materials/material_table.hpp>
+
+// Camera fields a scene file may set. Defaults match camera's, and the layout is
+// plain data so it can be stored in the compiled scene as is.
+struct scene_view {
+  double aspect_ratio = 1.0;
+  int32_t image_width = 100;
+  int32_t samples_per_pixel = 10;
+  int32_t max_depth = 10;
+  // 0 once the scene sets a background colour in place of the sky
+  int32_t use_sky = 1;
+  double look_from[3] = {0, 0, 0};
+  double look_at[3] = {0, 0, -1};
+  double v_up[3] = {0, 1, 0};
+  double v_fov = 90.0;
+  double background[3] = {0, 0, 0};
+  double defocus_angle = 0.0;
+  double focus_dist = 10.0;
+
+  void apply(camera& cam) const;
+};
+
+// Fixed-size records of the compiled scene; materials are referenced by their
+// position in the material list.
+enum class material_kind : uint32_t { lambertian = 0, metal = 1, dielectric = 2, light = 3 };
+
+struct material_record {
+  material_kind kind;
+  uint32_t padding;
+  // lambertian: albedo rgb; metal: albedo rgb, fuzz; dielectric: index of refraction;
+  // light: emitted radiance rgb
+  double params[4];
+};
+
+struct sphere_record {
+  double center[3];
+  double radius;
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct box_record {
+  double min_corner[3];
+  double max_corner[3];
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct plane_record {
+  double point[3];
+  double normal[3];
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct quad_record {
+  double corner[3];
+  double u[3];
+  double v[3];
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct mesh_record {
+  // Mesh file, relative to the scene file's directory unless absolute
+  char path[256];
+  uint32_t material;
+  uint32_t padding;
+};
+
+struct instance_record {
+  // Mesh file, shared by every instance of the same path
+  char path[256];
+  uint32_t material;
+  uint32_t padding;
+  // Object-to-world transform, affine_transform::m row by row
+  double object_to_world[12];
+};
+
+// Read-only view of count records, from a std::vector or straight from the mapping
+template <typename T>
+struct record_span {
+  const T* data = nullptr;
+  size_t count = 0;
+
+  const T* begin() const { return data; }
+  const T* end() const { return data + count; }
+};
+
+// A scene loaded from a text description:
+//
+//   # comment
+//   camera <field> <values...>   fields: aspect_ratio, image_width, samples_per_pixel,
+//                                max_depth, look_from x y z, look_at x y z, v_up x y z, v_fov,
+//                                background r g b (replaces the sky), defocus_angle,
+//                                focus_dist
+//   material <name> lambertian r g b
+//   material <name> metal r g b fuzz
+//   material <name> dielectric ior
+//   material <name> light r g b  emits radiance r g b
+//   sphere cx cy cz radius <material>
+//   box x0 y0 z0 x1 y1 z1 <material>
+//   plane px py pz nx ny nz <material>
+//   quad cx cy cz ux uy uz vx vy vz <material>
+//                                parallelogram with corner c and edges u and v; lights
+//                                shine toward cross(u, v)
+//   mesh <file.obj|file.ply> <material>
+//   instance <file.obj|file.ply> <material> [transform...]
+//                                transforms, applied in the order given:
+//                                translate x y z, scale x y z, rotate ax ay az degrees
+//
+// The first load compiles the text into "<path>.bin" next to it: a header and the
+// record arrays above, back to back. Later loads mmap that file and build the scene
+// straight from the arrays as long as the source's size and modification time still
+// match the ones recorded in the header. Mesh files are not copied into it; they
+// are read (memory-mapped) on every load. Each instanced file is loaded once and
+// shared by all of its instances.
+//
+// Spheres, boxes and quads with a light material are also put in lights, which
+// the integrator samples directly. Light meshes and planes still emit, but are
+// only found by paths that happen to hit them.
+class scene {
+public:
+  scene_view view;
+  material_table materials;
+  // Spheres are grouped into sphere_sets of nearby spheres, except huge ones; everything
+  // else is one object per shape.
+  hittable_list world;
+  hittable_list lights;
+  // Hash of the loaded records and of the size and modification time of every
+  // mesh file they use; changes whenever the scene's content does.
+  uint64_t fingerprint = 0;
+
+  // Loads path, via its compiled form when that is current. Errors are reported
+  // on std::cerr.
+  bool load(const std::string& path);
+  // Compiled form's path for a scene file
+  static std::string cache_path(const std::string& path);
+
+private:
+  struct source {
+    std::vector<material_record> materials;
+    std::vector<sphere_record> spheres;
+    std::vector<box_record> boxes;
+    std::vector<plane_record> planes;
+    std::vector<quad_record> quads;
+    std::vector<mesh_record> meshes;
+    std::vector<instance_record> instances;
+  };
+
+  static bool parse(const std::string& path, scene_view& view, source& out);
+  static bool write_cache(const std::string& path, const scene_view& view, const source& data,
+                          uint64_t source_size, int64_t source_mtime);
+  // False if there is no current, intact compiled form; otherwise built tells
+  // whether the scene could be built from it.
+  bool load_cache(const std::string& path, const std::string& cache, uint64_t source_size, int64_t source_mtime,
+                  bool& built);
+  bool build(const std::string& path, record_span<material_record> material_data,
+             record_span<sphere_record> sphere_data, record_span<box_record> box_data,
+             record_span<plane_record> plane_data, record_span<quad_record> quad_data,
+             record_span<mesh_record> mesh_data, record_span<instance_record> instance_data);
+};
+
+#endif
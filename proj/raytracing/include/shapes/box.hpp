@@ -3,14 +3,17 @@
 
 #include <cmath>
 #include <limits>
-#include <memory>
 
 #include <objects/hittable.hpp>
 #include <objects/ray.hpp>
 #include <objects/vec3.hpp>
 #include <objects/hit_record.hpp>
 #include <objects/interval.hpp>
-#include <materials/base.hpp>
+
+#include <render/render_stats.hpp>
+
+#include <constants.hpp>
+#include <randomizer.hpp>
 
 // Axis-Aligned Bounding Box (AABB) primitive as a hittable.
 // Defined by its minimum and maximum corner points in 3D space.
@@ -22,17 +25,19 @@
 // If after processing all axes the interval is valid (t_max > t_min) and
 // overlaps the requested ray_interval, we have a hit.
 //
-// The normal is determined from which axis produced the final entering t.
+// The normal is determined from which axis produced the final entering t; that
+// axis travels as the intersection's primitive so the normal is only worked
+// out for the closest hit.
 class box : public hittable {
 public:
   point3 min_corner;
   point3 max_corner;
-  std::shared_ptr<material> mat;
+  material_id mat = no_material;
 
   box() = default;
 
-  box(const point3& min_c, const point3& max_c, std::shared_ptr<material> m)
-    : min_corner(min_c), max_corner(max_c), mat(std::move(m)) {
+  box(const point3& min_c, const point3& max_c, material_id m)
+    : min_corner(min_c), max_corner(max_c), mat(m) {
     // Ensure ordering (in case user swapped inputs).
     for (int i = 0; i < 3; ++i) {
       if (min_corner.e[i] > max_corner.e[i]) {
@@ -42,13 +47,14 @@ public:
   }
 
   // Convenience constructor: center + size (uniform)
-  box(const point3& center, double extent, std::shared_ptr<material> m) : mat(std::move(m)) {
+  box(const point3& center, double extent, material_id m) : mat(m) {
     double h = extent * 0.5;
     min_corner = point3(center.x() - h, center.y() - h, center.z() - h);
     max_corner = point3(center.x() + h, center.y() + h, center.z() + h);
   }
 
-  bool hit(const ray& r, interval ray_interval, hit_record& rec) const override {
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override {
+    RT_STAT_INC(box_tests);
     // For numerical robustness: if direction component is 0, treat as very close to 0
     // but we explicitly handle the parallel case.
 
@@ -96,11 +102,19 @@ public:
         return false;
       }
       // Hitting from inside the box; treat t_exit as the outward hit.
-      rec.t = t_exit;
+      isect.t = t_exit;
     } else {
-      rec.t = t_enter;
+      isect.t = t_enter;
     }
 
+    isect.object = this;
+    isect.primitive = static_cast<uint32_t>(enter_axis + 1);
+    return true;
+  }
+
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override {
+    const int enter_axis = static_cast<int>(isect.primitive) - 1;
+    rec.t = isect.t;
     rec.p = r.at(rec.t);
     rec.mat = mat;
 
@@ -154,7 +168,68 @@ public:
     }
 
     rec.set_face_normal(r, outward_normal);
-    return true;
+  }
+
+  aabb bounding_box() const override {
+    return aabb(min_corner, max_corner);
+  }
+
+  // Light sampling picks a uniform point on the faces turned toward origin (at
+  // most three), so a ray from origin enters the box through the sampled face.
+  vec3 random_direction(const point3& origin) const override {
+    double pick = random_double() * visible_area(origin);
+    int axis = -1;
+    for (int candidate = 0; candidate < 3; ++candidate) {
+      double area = face_area(origin, candidate);
+      if (area <= 0) {
+        continue;
+      }
+      axis = candidate;
+      if (pick < area) {
+        break;
+      }
+      pick -= area;
+    }
+    if (axis < 0) {
+      // origin is inside the box; pdf_value is 0 for every direction.
+      return vec3(1, 0, 0);
+    }
+
+    const int a = (axis + 1) % 3;
+    const int b = (axis + 2) % 3;
+    point3 on_face;
+    on_face.e[axis] = origin[axis] < min_corner[axis] ? min_corner[axis] : max_corner[axis];
+    on_face.e[a] = min_corner[a] + random_double() * (max_corner[a] - min_corner[a]);
+    on_face.e[b] = min_corner[b] + random_double() * (max_corner[b] - min_corner[b]);
+    return on_face - origin;
+  }
+
+  double pdf_value(const point3& origin, const vec3& direction) const override {
+    const double visible = visible_area(origin);
+    intersection isect;
+    if (visible <= 0 || !intersect(ray(origin, direction), interval(0.001, INF), isect) || isect.primitive == 0) {
+      return 0.0;
+    }
+    const int axis = static_cast<int>(isect.primitive) - 1;
+    const double length = direction.length();
+    const double distance = isect.t * length;
+    const double cosine = std::fabs(direction[axis]) / length;
+    return distance * distance / (cosine * visible);
+  }
+
+private:
+  // Area of the face on axis that faces origin; 0 if origin is between the slabs.
+  double face_area(const point3& origin, int axis) const {
+    if (origin[axis] >= min_corner[axis] && origin[axis] <= max_corner[axis]) {
+      return 0.0;
+    }
+    const int a = (axis + 1) % 3;
+    const int b = (axis + 2) % 3;
+    return (max_corner[a] - min_corner[a]) * (max_corner[b] - min_corner[b]);
+  }
+
+  double visible_area(const point3& origin) const {
+    return face_area(origin, 0) + face_area(origin, 1) + face_area(origin, 2);
   }
 };
 
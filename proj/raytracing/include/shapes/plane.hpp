@@ -1,14 +1,14 @@
 #ifndef __PLANE_HPP__
 #define __PLANE_HPP__
 
-#include <memory>
 #include <cmath>
 
 #include <objects/hittable.hpp>
 #include <objects/vec3.hpp>
 #include <objects/ray.hpp>
 #include <objects/hit_record.hpp>
-#include <materials/base.hpp>
+
+#include <render/render_stats.hpp>
 
 // Infinite plane defined by a point and a (normalized) surface normal.
 // Equation: dot(normal, (P - point)) = 0
@@ -16,12 +16,13 @@ class plane : public hittable {
 public:
   point3 p0;                       // A point on the plane
   vec3 n;                          // Outward normal (kept normalized)
-  std::shared_ptr<material> mat;   // Material of the plane
+  material_id mat;                 // Material of the plane
 
-  plane(const point3& point, const vec3& normal, std::shared_ptr<material> m)
-    : p0(point), n(unit_vector(normal)), mat(std::move(m)) {}
+  plane(const point3& point, const vec3& normal, material_id m)
+    : p0(point), n(unit_vector(normal)), mat(m) {}
 
-  bool hit(const ray& r, interval ray_interval, hit_record& rec) const override {
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override {
+    RT_STAT_INC(plane_tests);
     double denom = dot(n, r.direction());
     // If denom is near zero, the ray is parallel to the plane (no hit)
     const double EPS = 1e-8;
@@ -34,13 +35,23 @@ public:
       return false;
     }
 
-    rec.t = t;
-    rec.p = r.at(t);
+    isect.t = t;
+    isect.object = this;
+    isect.primitive = 0;
+    return true;
+  }
+
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override {
+    rec.t = isect.t;
+    rec.p = r.at(rec.t);
     rec.mat = mat;
     // Plane has fixed outward normal n; set face normal adjusts orientation
     rec.set_face_normal(r, n);
+  }
 
-    return true;
+  // An infinite plane has no finite bounds; acceleration structures keep it outside the tree.
+  aabb bounding_box() const override {
+    return aabb::universe;
   }
 };
 
@@ -0,0 +1,33 @@
+#ifndef __QUAD_HPP__
+#define __QUAD_HPP__
+
+#include <objects/hittable.hpp>
+#include <objects/vec3.hpp>
+
+// Parallelogram spanned by edges u and v from corner. Its front side is the one
+// cross(u, v) points to, which is the side a diffuse_light quad lights.
+class quad: public hittable {
+public:
+  point3 corner;
+  vec3 u, v;
+  material_id mat;
+
+  quad(const point3& _corner, const vec3& _u, const vec3& _v, material_id _material);
+
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override;
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override;
+  aabb bounding_box() const override;
+  // Samples a uniform point of the quad.
+  vec3 random_direction(const point3& origin) const override;
+  double pdf_value(const point3& origin, const vec3& direction) const override;
+
+private:
+  vec3 normal;
+  // Plane offset dot(normal, corner)
+  double offset;
+  // cross(u, v) / |cross(u, v)|^2, turns a point on the plane into (u, v) coordinates
+  vec3 w;
+  double area;
+};
+
+#endif
@@ -2,22 +2,27 @@
 #define __SPHERE_HPP__
 
 #include <algorithm>
-#include <memory>
 
 #include <objects/color.hpp>
 #include <objects/hittable.hpp>
 
-#include <materials/base.hpp>
-
 class sphere: public hittable {
 public:
   point3 center;
-  double radius;
-  std::shared_ptr<material> mat;
+  real radius;
+  material_id mat;
 
-  sphere(point3 _center, double _radius, std::shared_ptr<material> _material): center(_center), radius(std::max(0.0, _radius)), mat(_material) {}
+  sphere(point3 _center, double _radius, material_id _material): center(_center), radius(std::max(0.0, _radius)), mat(_material) {}
 
-  bool hit(const ray& r, interval ray_interval, hit_record& rec) const override;
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override;
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override;
+  aabb bounding_box() const override;
+  // Tests one sphere against several packet lanes per instruction.
+  uint32_t hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const override;
+  bool occluded(const ray& r, interval ray_interval) const override;
+  // Samples the cone of directions the sphere covers as seen from origin.
+  vec3 random_direction(const point3& origin) const override;
+  double pdf_value(const point3& origin, const vec3& direction) const override;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __SPHERE_SET_HPP__
+#define __SPHERE_SET_HPP__
+
+#include <cstdint>
+#include <vector>
+
+#include <objects/aabb.hpp>
+#include <objects/hittable.hpp>
+
+#include <aligned_allocator.hpp>
+#include <real.hpp>
+
+// A batch of spheres stored as a structure of arrays (centers, radii and material
+// indices in separate 64-byte aligned arrays) and intersected several at a time
+// with SIMD: 8 lanes with AVX-512, 4 with AVX, 2 with SSE2, scalar otherwise.
+// Lanes hold real, so float builds test twice as many spheres per instruction.
+// Only the closest hit is turned into a hit_record.
+class sphere_set: public hittable {
+public:
+  // Arrays are padded to a multiple of this (one 64-byte vector) so every SIMD
+  // width reads whole vectors.
+  static constexpr size_t lane_padding = 64 / sizeof(real);
+
+  sphere_set() {}
+
+  void add(const point3& center, double radius, material_id mat);
+  size_t size() const;
+  // Number of spheres tested per instruction by the kernel this build selected
+  static int simd_width();
+
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override;
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override;
+  aabb bounding_box() const override;
+  // Loads a SIMD vector of packet lanes once and tests it against every sphere,
+  // keeping each lane's closest hit in registers.
+  uint32_t hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const override;
+  // Stops after the first batch of spheres with a root in the interval.
+  bool occluded(const ray& r, interval ray_interval) const override;
+
+private:
+  aligned_vector<real> center_x, center_y, center_z, radius;
+  aligned_vector<material_id> material_index;
+  size_t count = 0;
+  aabb bbox;
+};
+
+#endif
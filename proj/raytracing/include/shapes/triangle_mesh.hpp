@@ -0,0 +1,44 @@
+#ifndef __TRIANGLE_MESH_HPP__
+#define __TRIANGLE_MESH_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <objects/aabb.hpp>
+#include <objects/bvh.hpp>
+#include <objects/hittable.hpp>
+
+// Indexed triangle mesh: one shared vertex buffer and an index buffer with three
+// vertex indices per triangle, instead of one hittable per triangle. The mesh
+// builds a bvh_tree over its own triangles and reorders the index buffer into leaf
+// order, so to the rest of the scene it is a single object with a single box.
+//
+// Rays are tested with the watertight algorithm of Woop, Benthin and Wald (2013):
+// vertices are moved into a ray-aligned, sheared frame where the test reduces to
+// 2D edge functions, so rays through shared edges and vertices never slip between
+// neighbouring triangles.
+class triangle_mesh: public hittable {
+public:
+  triangle_mesh(std::vector<point3> vertices, std::vector<uint32_t> indices, material_id mat);
+
+  // Reads a Wavefront OBJ or binary PLY file (chosen by extension). Returns
+  // nullptr, after reporting on std::cerr, if the file cannot be read.
+  static std::shared_ptr<triangle_mesh> load(const std::string& path, material_id mat);
+
+  bool intersect(const ray& r, interval ray_interval, intersection& isect) const override;
+  void surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const override;
+  aabb bounding_box() const override;
+  bool occluded(const ray& r, interval ray_interval) const override;
+
+  size_t triangle_count() const;
+
+private:
+  std::vector<point3> vertices;
+  // Three vertex indices per triangle, in BVH leaf order
+  std::vector<uint32_t> indices;
+  material_id mat;
+  bvh_tree tree;
+};
+
+#endif
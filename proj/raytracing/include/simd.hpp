@@ -0,0 +1,199 @@
+#ifndef __SIMD_HPP__
+#define __SIMD_HPP__
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <real.hpp>
+
+// Thin wrappers over the widest vector instruction set enabled at compile time, so
+// intersection kernels are written once for every width. simd_lanes<double> has 8
+// lanes with AVX-512, 4 with AVX and 2 with SSE2; simd_lanes<float> has twice as
+// many. Without any of them the primary template runs one lane in scalar code.
+// bits() packs a comparison mask into an integer with one bit per lane. Like the
+// underlying instructions, max(a, b) and min(a, b) return b when either is NaN.
+template <typename T>
+struct simd_lanes {
+  using vd = T;
+  using mask = bool;
+  static constexpr int width = 1;
+  static vd set1(T x) { return x; }
+  static vd lane_index() { return 0; }
+  static vd load(const T* p) { return *p; }
+  static vd loadu(const T* p) { return *p; }
+  static void store(T* p, vd v) { *p = v; }
+  static vd add(vd a, vd b) { return a + b; }
+  static vd sub(vd a, vd b) { return a - b; }
+  static vd mul(vd a, vd b) { return a * b; }
+  static vd sqrt(vd a) { return std::sqrt(a); }
+  static vd max(vd a, vd b) { return a > b ? a : b; }
+  static vd min(vd a, vd b) { return a < b ? a : b; }
+  static mask ge(vd a, vd b) { return a >= b; }
+  static mask gt(vd a, vd b) { return a > b; }
+  static mask lt(vd a, vd b) { return a < b; }
+  static mask both(mask a, mask b) { return a && b; }
+  static mask either(mask a, mask b) { return a || b; }
+  static int bits(mask m) { return m ? 1 : 0; }
+  static vd select(mask m, vd if_true, vd if_false) { return m ? if_true : if_false; }
+};
+
+#if defined(__AVX512F__)
+template <>
+struct simd_lanes<double> {
+  using vd = __m512d;
+  using mask = __mmask8;
+  static constexpr int width = 8;
+  static vd set1(double x) { return _mm512_set1_pd(x); }
+  static vd lane_index() { return _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7); }
+  static vd load(const double* p) { return _mm512_load_pd(p); }
+  static vd loadu(const double* p) { return _mm512_loadu_pd(p); }
+  static void store(double* p, vd v) { _mm512_store_pd(p, v); }
+  static vd add(vd a, vd b) { return _mm512_add_pd(a, b); }
+  static vd sub(vd a, vd b) { return _mm512_sub_pd(a, b); }
+  static vd mul(vd a, vd b) { return _mm512_mul_pd(a, b); }
+  static vd sqrt(vd a) { return _mm512_sqrt_pd(a); }
+  static vd max(vd a, vd b) { return _mm512_max_pd(a, b); }
+  static vd min(vd a, vd b) { return _mm512_min_pd(a, b); }
+  static mask ge(vd a, vd b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+  static mask gt(vd a, vd b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+  static mask lt(vd a, vd b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+  static mask both(mask a, mask b) { return a & b; }
+  static mask either(mask a, mask b) { return a | b; }
+  static int bits(mask m) { return static_cast<int>(m); }
+  static vd select(mask m, vd if_true, vd if_false) { return _mm512_mask_blend_pd(m, if_false, if_true); }
+};
+
+template <>
+struct simd_lanes<float> {
+  using vd = __m512;
+  using mask = __mmask16;
+  static constexpr int width = 16;
+  static vd set1(float x) { return _mm512_set1_ps(x); }
+  static vd lane_index() { return _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+  static vd load(const float* p) { return _mm512_load_ps(p); }
+  static vd loadu(const float* p) { return _mm512_loadu_ps(p); }
+  static void store(float* p, vd v) { _mm512_store_ps(p, v); }
+  static vd add(vd a, vd b) { return _mm512_add_ps(a, b); }
+  static vd sub(vd a, vd b) { return _mm512_sub_ps(a, b); }
+  static vd mul(vd a, vd b) { return _mm512_mul_ps(a, b); }
+  static vd sqrt(vd a) { return _mm512_sqrt_ps(a); }
+  static vd max(vd a, vd b) { return _mm512_max_ps(a, b); }
+  static vd min(vd a, vd b) { return _mm512_min_ps(a, b); }
+  static mask ge(vd a, vd b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+  static mask gt(vd a, vd b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+  static mask lt(vd a, vd b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+  static mask both(mask a, mask b) { return a & b; }
+  static mask either(mask a, mask b) { return a | b; }
+  static int bits(mask m) { return static_cast<int>(m); }
+  static vd select(mask m, vd if_true, vd if_false) { return _mm512_mask_blend_ps(m, if_false, if_true); }
+};
+#elif defined(__AVX__)
+template <>
+struct simd_lanes<double> {
+  using vd = __m256d;
+  using mask = __m256d;
+  static constexpr int width = 4;
+  static vd set1(double x) { return _mm256_set1_pd(x); }
+  static vd lane_index() { return _mm256_setr_pd(0, 1, 2, 3); }
+  static vd load(const double* p) { return _mm256_load_pd(p); }
+  static vd loadu(const double* p) { return _mm256_loadu_pd(p); }
+  static void store(double* p, vd v) { _mm256_store_pd(p, v); }
+  static vd add(vd a, vd b) { return _mm256_add_pd(a, b); }
+  static vd sub(vd a, vd b) { return _mm256_sub_pd(a, b); }
+  static vd mul(vd a, vd b) { return _mm256_mul_pd(a, b); }
+  static vd sqrt(vd a) { return _mm256_sqrt_pd(a); }
+  static vd max(vd a, vd b) { return _mm256_max_pd(a, b); }
+  static vd min(vd a, vd b) { return _mm256_min_pd(a, b); }
+  static mask ge(vd a, vd b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+  static mask gt(vd a, vd b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+  static mask lt(vd a, vd b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+  static mask both(mask a, mask b) { return _mm256_and_pd(a, b); }
+  static mask either(mask a, mask b) { return _mm256_or_pd(a, b); }
+  static int bits(mask m) { return _mm256_movemask_pd(m); }
+  static vd select(mask m, vd if_true, vd if_false) { return _mm256_blendv_pd(if_false, if_true, m); }
+};
+
+template <>
+struct simd_lanes<float> {
+  using vd = __m256;
+  using mask = __m256;
+  static constexpr int width = 8;
+  static vd set1(float x) { return _mm256_set1_ps(x); }
+  static vd lane_index() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+  static vd load(const float* p) { return _mm256_load_ps(p); }
+  static vd loadu(const float* p) { return _mm256_loadu_ps(p); }
+  static void store(float* p, vd v) { _mm256_store_ps(p, v); }
+  static vd add(vd a, vd b) { return _mm256_add_ps(a, b); }
+  static vd sub(vd a, vd b) { return _mm256_sub_ps(a, b); }
+  static vd mul(vd a, vd b) { return _mm256_mul_ps(a, b); }
+  static vd sqrt(vd a) { return _mm256_sqrt_ps(a); }
+  static vd max(vd a, vd b) { return _mm256_max_ps(a, b); }
+  static vd min(vd a, vd b) { return _mm256_min_ps(a, b); }
+  static mask ge(vd a, vd b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+  static mask gt(vd a, vd b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+  static mask lt(vd a, vd b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static mask both(mask a, mask b) { return _mm256_and_ps(a, b); }
+  static mask either(mask a, mask b) { return _mm256_or_ps(a, b); }
+  static int bits(mask m) { return _mm256_movemask_ps(m); }
+  static vd select(mask m, vd if_true, vd if_false) { return _mm256_blendv_ps(if_false, if_true, m); }
+};
+#elif defined(__SSE2__)
+template <>
+struct simd_lanes<double> {
+  using vd = __m128d;
+  using mask = __m128d;
+  static constexpr int width = 2;
+  static vd set1(double x) { return _mm_set1_pd(x); }
+  static vd lane_index() { return _mm_setr_pd(0, 1); }
+  static vd load(const double* p) { return _mm_load_pd(p); }
+  static vd loadu(const double* p) { return _mm_loadu_pd(p); }
+  static void store(double* p, vd v) { _mm_store_pd(p, v); }
+  static vd add(vd a, vd b) { return _mm_add_pd(a, b); }
+  static vd sub(vd a, vd b) { return _mm_sub_pd(a, b); }
+  static vd mul(vd a, vd b) { return _mm_mul_pd(a, b); }
+  static vd sqrt(vd a) { return _mm_sqrt_pd(a); }
+  static vd max(vd a, vd b) { return _mm_max_pd(a, b); }
+  static vd min(vd a, vd b) { return _mm_min_pd(a, b); }
+  static mask ge(vd a, vd b) { return _mm_cmpge_pd(a, b); }
+  static mask gt(vd a, vd b) { return _mm_cmpgt_pd(a, b); }
+  static mask lt(vd a, vd b) { return _mm_cmplt_pd(a, b); }
+  static mask both(mask a, mask b) { return _mm_and_pd(a, b); }
+  static mask either(mask a, mask b) { return _mm_or_pd(a, b); }
+  static int bits(mask m) { return _mm_movemask_pd(m); }
+  // SSE2 has no blend instruction
+  static vd select(mask m, vd if_true, vd if_false) { return _mm_or_pd(_mm_and_pd(m, if_true), _mm_andnot_pd(m, if_false)); }
+};
+
+template <>
+struct simd_lanes<float> {
+  using vd = __m128;
+  using mask = __m128;
+  static constexpr int width = 4;
+  static vd set1(float x) { return _mm_set1_ps(x); }
+  static vd lane_index() { return _mm_setr_ps(0, 1, 2, 3); }
+  static vd load(const float* p) { return _mm_load_ps(p); }
+  static vd loadu(const float* p) { return _mm_loadu_ps(p); }
+  static void store(float* p, vd v) { _mm_store_ps(p, v); }
+  static vd add(vd a, vd b) { return _mm_add_ps(a, b); }
+  static vd sub(vd a, vd b) { return _mm_sub_ps(a, b); }
+  static vd mul(vd a, vd b) { return _mm_mul_ps(a, b); }
+  static vd sqrt(vd a) { return _mm_sqrt_ps(a); }
+  static vd max(vd a, vd b) { return _mm_max_ps(a, b); }
+  static vd min(vd a, vd b) { return _mm_min_ps(a, b); }
+  static mask ge(vd a, vd b) { return _mm_cmpge_ps(a, b); }
+  static mask gt(vd a, vd b) { return _mm_cmpgt_ps(a, b); }
+  static mask lt(vd a, vd b) { return _mm_cmplt_ps(a, b); }
+  static mask both(mask a, mask b) { return _mm_and_ps(a, b); }
+  static mask either(mask a, mask b) { return _mm_or_ps(a, b); }
+  static int bits(mask m) { return _mm_movemask_ps(m); }
+  static vd select(mask m, vd if_true, vd if_false) { return _mm_or_ps(_mm_and_ps(m, if_true), _mm_andnot_ps(m, if_false)); }
+};
+#endif
+
+// Lanes of the geometry scalar type, used by the intersection kernels
+using simd = simd_lanes<real>;
+
+#endif
@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <queue>
+
+#include <io/deflate.hpp>
+
+namespace {
+
+constexpr int window_size = 32768;
+constexpr int hash_bits = 15;
+constexpr int hash_size = 1 << hash_bits;
+constexpr int min_match = 3;
+constexpr int max_match = 258;
+// Candidates examined per position; trades compression ratio for speed.
+constexpr int max_chain = 32;
+// Tokens gathered before a block is emitted with its own Huffman trees.
+constexpr size_t block_tokens = 1 << 15;
+
+constexpr int literal_codes = 286;
+constexpr int distance_codes = 30;
+constexpr int length_codes = 19;
+constexpr int end_of_block = 256;
+
+const uint16_t length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Order in which code length code lengths are transmitted
+const uint8_t length_code_order[length_codes] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct token {
+  uint16_t length;    // match length, or the literal byte when distance == 0
+  uint16_t distance;
+};
+
+int length_symbol(int length) {
+  int code = static_cast<int>(std::upper_bound(length_base, length_base + 29, length) - length_base) - 1;
+  return code;
+}
+
+int distance_symbol(int distance) {
+  return static_cast<int>(std::upper_bound(distance_base, distance_base + 30, distance) - distance_base) - 1;
+}
+
+class bit_writer {
+public:
+  std::vector<uint8_t> bytes;
+
+  void put(uint32_t bits, int count) {
+    buffer |= static_cast<uint64_t>(bits) << filled;
+    filled += count;
+    while (filled >= 8) {
+      bytes.push_back(static_cast<uint8_t>(buffer));
+      buffer >>= 8;
+      filled -= 8;
+    }
+  }
+
+  void align() {
+    if (filled > 0) {
+      put(0, 8 - filled);
+    }
+  }
+
+private:
+  uint64_t buffer = 0;
+  int filled = 0;
+};
+
+// Canonical Huffman code with lengths limited to max_bits; codes are stored
+// bit-reversed because DEFLATE sends Huffman codes most significant bit first.
+struct huffman_code {
+  std::vector<uint8_t> lengths;
+  std::vector<uint16_t> codes;
+
+  void build(const std::vector<uint32_t>& freq, int max_bits) {
+    const int n = static_cast<int>(freq.size());
+    lengths.assign(n, 0);
+    codes.assign(n, 0);
+
+    std::vector<int> used;
+    for (int s = 0; s < n; ++s) {
+      if (freq[s] > 0) used.push_back(s);
+    }
+    if (used.empty()) {
+      return;
+    }
+    if (used.size() == 1) {
+      // Pad a lone symbol with a dummy so the code is complete.
+      lengths[used[0]] = 1;
+      lengths[used[0] == 0 ? 1 : 0] = 1;
+      assign_codes(max_bits);
+      return;
+    }
+
+    // Plain Huffman tree to get the unlimited code lengths
+    struct node {
+      uint64_t weight;
+      int left, right;
+    };
+    std::vector<node> nodes;
+    using entry = std::pair<uint64_t, int>;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+    for (int s : used) {
+      nodes.push_back({freq[s], -1, s});
+      queue.push({freq[s], static_cast<int>(nodes.size()) - 1});
+    }
+    while (queue.size() > 1) {
+      entry a = queue.top(); queue.pop();
+      entry b = queue.top(); queue.pop();
+      nodes.push_back({a.first + b.first, a.second, b.second});
+      queue.push({a.first + b.first, static_cast<int>(nodes.size()) - 1});
+    }
+
+    std::vector<int> depth_count(64, 0);
+    std::vector<std::pair<int, int>> stack = {{queue.top().second, 0}};
+    while (!stack.empty()) {
+      auto [index, depth] = stack.back();
+      stack.pop_back();
+      const node& nd = nodes[index];
+      if (nd.left < 0) {
+        depth_count[std::min(depth, 63)]++;
+      } else {
+        stack.push_back({nd.left, depth + 1});
+        stack.push_back({nd.right, depth + 1});
+      }
+    }
+
+    // Fold lengths beyond max_bits back in while keeping the Kraft sum exact.
+    for (int len = max_bits + 1; len < 64; ++len) {
+      depth_count[max_bits] += depth_count[len];
+      depth_count[len] = 0;
+    }
+    uint64_t kraft = 0;
+    for (int len = 1; len <= max_bits; ++len) {
+      kraft += static_cast<uint64_t>(depth_count[len]) << (max_bits - len);
+    }
+    while (kraft > (1ull << max_bits)) {
+      depth_count[max_bits]--;
+      for (int len = max_bits - 1; len > 0; --len) {
+        if (depth_count[len] > 0) {
+          depth_count[len]--;
+          depth_count[len + 1] += 2;
+          break;
+        }
+      }
+      kraft--;
+    }
+
+    // Most frequent symbols get the shortest codes.
+    std::stable_sort(used.begin(), used.end(), [&](int a, int b) { return freq[a] > freq[b]; });
+    size_t k = 0;
+    for (int len = 1; len <= max_bits; ++len) {
+      for (int c = 0; c < depth_count[len]; ++c) {
+        lengths[used[k++]] = static_cast<uint8_t>(len);
+      }
+    }
+    assign_codes(max_bits);
+  }
+
+private:
+  void assign_codes(int max_bits) {
+    std::vector<int> count(max_bits + 1, 0);
+    for (uint8_t len : lengths) {
+      if (len) count[len]++;
+    }
+    std::vector<uint32_t> next(max_bits + 2, 0);
+    uint32_t code = 0;
+    for (int len = 1; len <= max_bits; ++len) {
+      code = (code + count[len - 1]) << 1;
+      next[len] = code;
+    }
+    for (size_t s = 0; s < lengths.size(); ++s) {
+      int len = lengths[s];
+      if (len == 0) continue;
+      uint32_t value = next[len]++;
+      uint32_t reversed = 0;
+      for (int b = 0; b < len; ++b) {
+        reversed = (reversed << 1) | ((value >> b) & 1);
+      }
+      codes[s] = static_cast<uint16_t>(reversed);
+    }
+  }
+};
+
+void write_dynamic_block(bit_writer& out, const std::vector<token>& tokens, bool final_block) {
+  std::vector<uint32_t> literal_freq(literal_codes, 0);
+  std::vector<uint32_t> distance_freq(distance_codes, 0);
+  for (const token& t : tokens) {
+    if (t.distance == 0) {
+      literal_freq[t.length]++;
+    } else {
+      literal_freq[257 + length_symbol(t.length)]++;
+      distance_freq[distance_symbol(t.distance)]++;
+    }
+  }
+  literal_freq[end_of_block]++;
+
+  huffman_code literal_code, distance_code;
+  literal_code.build(literal_freq, 15);
+  distance_code.build(distance_freq, 15);
+
+  int literal_count = literal_codes;
+  while (literal_count > 257 && literal_code.lengths[literal_count - 1] == 0) --literal_count;
+  int distance_count = distance_codes;
+  while (distance_count > 1 && distance_code.lengths[distance_count - 1] == 0) --distance_count;
+
+  // Run-length encode the concatenated code lengths with symbols 16/17/18.
+  std::vector<uint8_t> all_lengths(literal_code.lengths.begin(), literal_code.lengths.begin() + literal_count);
+  all_lengths.insert(all_lengths.end(), distance_code.lengths.begin(), distance_code.lengths.begin() + distance_count);
+
+  struct rle_symbol {
+    uint8_t symbol;
+    uint8_t extra;
+  };
+  std::vector<rle_symbol> rle;
+  for (size_t i = 0; i < all_lengths.size();) {
+    uint8_t len = all_lengths[i];
+    size_t run = 1;
+    while (i + run < all_lengths.size() && all_lengths[i + run] == len) ++run;
+
+    if (len == 0 && run >= 3) {
+      size_t take = std::min<size_t>(run, 138);
+      if (take >= 11) {
+        rle.push_back({18, static_cast<uint8_t>(take - 11)});
+      } else {
+        rle.push_back({17, static_cast<uint8_t>(take - 3)});
+      }
+      i += take;
+    } else if (len != 0 && run >= 4) {
+      rle.push_back({len, 0});
+      size_t take = std::min<size_t>(run - 1, 6);
+      rle.push_back({16, static_cast<uint8_t>(take - 3)});
+      i += 1 + take;
+    } else {
+      rle.push_back({len, 0});
+      i += 1;
+    }
+  }
+
+  std::vector<uint32_t> length_freq(length_codes, 0);
+  for (const rle_symbol& r : rle) length_freq[r.symbol]++;
+  huffman_code length_code;
+  length_code.build(length_freq, 7);
+
+  int length_count = length_codes;
+  while (length_count > 4 && length_code.lengths[length_code_order[length_count - 1]] == 0) --length_count;
+
+  out.put(final_block ? 1 : 0, 1);
+  out.put(2, 2);
+  out.put(literal_count - 257, 5);
+  out.put(distance_count - 1, 5);
+  out.put(length_count - 4, 4);
+  for (int k = 0; k < length_count; ++k) {
+    out.put(length_code.lengths[length_code_order[k]], 3);
+  }
+  for (const rle_symbol& r : rle) {
+    out.put(length_code.codes[r.symbol], length_code.lengths[r.symbol]);
+    if (r.symbol == 16) out.put(r.extra, 2);
+    else if (r.symbol == 17) out.put(r.extra, 3);
+    else if (r.symbol == 18) out.put(r.extra, 7);
+  }
+
+  for (const token& t : tokens) {
+    if (t.distance == 0) {
+      out.put(literal_code.codes[t.length], literal_code.lengths[t.length]);
+      continue;
+    }
+    int ls = length_symbol(t.length);
+    out.put(literal_code.codes[257 + ls], literal_code.lengths[257 + ls]);
+    out.put(t.length - length_base[ls], length_extra[ls]);
+    int ds = distance_symbol(t.distance);
+    out.put(distance_code.codes[ds], distance_code.lengths[ds]);
+    out.put(t.distance - distance_base[ds], distance_extra[ds]);
+  }
+  out.put(literal_code.codes[end_of_block], literal_code.lengths[end_of_block]);
+}
+
+uint32_t hash3(const uint8_t* p) {
+  return ((static_cast<uint32_t>(p[0]) << 10) ^ (static_cast<uint32_t>(p[1]) << 5) ^ p[2]) & (hash_size - 1);
+}
+
+}
+
+std::vector<uint8_t> deflate_chunk(const uint8_t* data, size_t size, bool final_chunk) {
+  bit_writer out;
+  std::vector<int32_t> head(hash_size, -1);
+  std::vector<int32_t> prev(window_size, -1);
+  std::vector<token> tokens;
+  tokens.reserve(block_tokens);
+
+  auto insert = [&](size_t pos) {
+    if (pos + min_match > size) return;
+    uint32_t h = hash3(data + pos);
+    prev[pos & (window_size - 1)] = head[h];
+    head[h] = static_cast<int32_t>(pos);
+  };
+
+  size_t pos = 0;
+  while (pos < size) {
+    int best_length = 0;
+    int best_distance = 0;
+    if (pos + min_match <= size) {
+      const size_t limit = std::min<size_t>(max_match, size - pos);
+      int32_t candidate = head[hash3(data + pos)];
+      for (int chain = 0; candidate >= 0 && chain < max_chain; ++chain) {
+        size_t distance = pos - static_cast<size_t>(candidate);
+        if (distance > window_size) break;
+        const uint8_t* a = data + candidate;
+        const uint8_t* b = data + pos;
+        if (a[best_length] == b[best_length]) {
+          size_t length = 0;
+          while (length < limit && a[length] == b[length]) ++length;
+          if (static_cast<int>(length) > best_length) {
+            best_length = static_cast<int>(length);
+            best_distance = static_cast<int>(distance);
+            if (length == limit) break;
+          }
+        }
+        int32_t next = prev[candidate & (window_size - 1)];
+        if (next >= candidate) break;  // slot was overwritten by a newer position
+        candidate = next;
+      }
+    }
+
+    if (best_length >= min_match) {
+      tokens.push_back({static_cast<uint16_t>(best_length), static_cast<uint16_t>(best_distance)});
+      for (int k = 0; k < best_length; ++k) insert(pos + k);
+      pos += best_length;
+    } else {
+      tokens.push_back({data[pos], 0});
+      insert(pos);
+      pos += 1;
+    }
+
+    if (tokens.size() >= block_tokens && pos < size) {
+      write_dynamic_block(out, tokens, false);
+      tokens.clear();
+    }
+  }
+
+  write_dynamic_block(out, tokens, final_chunk);
+  if (!final_chunk) {
+    // Empty stored block: realigns to a byte boundary so the next chunk can follow.
+    out.put(0, 3);
+    out.align();
+    out.put(0x0000, 16);
+    out.put(0xffff, 16);
+  }
+  out.align();
+  return out.bytes;
+}
+
+uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler) {
+  const uint32_t mod = 65521;
+  uint32_t a = adler & 0xffff;
+  uint32_t b = adler >> 16;
+  while (size > 0) {
+    // 5552 is the largest run that cannot overflow 32 bits before reducing.
+    size_t run = std::min<size_t>(size, 5552);
+    size -= run;
+    while (run--) {
+      a += *data++;
+      b += a;
+    }
+    a %= mod;
+    b %= mod;
+  }
+  return (b << 16) | a;
+}
+
+uint32_t adler32_combine(uint32_t adler_a, uint32_t adler_b, size_t size_b) {
+  const uint32_t mod = 65521;
+  uint32_t rem = static_cast<uint32_t>(size_b % mod);
+  uint32_t sum1 = adler_a & 0xffff;
+  uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % mod);
+  sum1 += (adler_b & 0xffff) + mod - 1;
+  sum2 += (adler_a >> 16) + (adler_b >> 16) + mod - rem;
+  if (sum1 >= mod) sum1 -= mod;
+  if (sum1 >= mod) sum1 -= mod;
+  if (sum2 >= (mod << 1)) sum2 -= (mod << 1);
+  if (sum2 >= mod) sum2 -= mod;
+  return sum1 | (sum2 << 16);
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc) {
+  static const std::vector<uint32_t> table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      t[n] = c;
+    }
+    return t;
+  }();
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
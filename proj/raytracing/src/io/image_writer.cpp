@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <io/image_writer.hpp>
+
+#include <render/timeline.hpp>
+
+#include <simd.hpp>
+
+namespace {
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+  if (s.size() < suffix.size()) return false;
+  return std::equal(suffix.rbegin(), suffix.rend(), s.rbegin(), [](char a, char b) {
+    return std::tolower(static_cast<unsigned char>(a)) == b;
+  });
+}
+
+template <typename T>
+void append_raw(std::vector<char>& out, const T& value) {
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void append_string(std::vector<char>& out, const char* s) {
+  out.insert(out.end(), s, s + std::strlen(s) + 1);
+}
+
+// Reads the colors as one flat array of channels, several per instruction. Padded
+// vectors (RAYTRACING_SIMD_VEC3) are converted one channel at a time.
+template <typename T>
+void display_bytes(const basic_vec3<T>* pixels, size_t count, uint8_t* out) {
+  size_t i = 0;
+  if constexpr (sizeof(basic_vec3<T>) == 3 * sizeof(T)) {
+    using lanes = simd_lanes<T>;
+    const T* values = pixels->e;
+    const size_t n = count * 3;
+
+    const typename lanes::vd zero = lanes::set1(0);
+    const typename lanes::vd upper = lanes::set1(0.999);
+    const typename lanes::vd scale = lanes::set1(256);
+    alignas(64) T scaled[lanes::width];
+
+    for (; i + lanes::width <= n; i += lanes::width) {
+      // max(x, 0) also maps NaN to 0, like linear_to_gamma.
+      typename lanes::vd v = lanes::sqrt(lanes::max(lanes::loadu(values + i), zero));
+      lanes::store(scaled, lanes::mul(lanes::min(v, upper), scale));
+      for (int k = 0; k < lanes::width; ++k) {
+        out[i + k] = static_cast<uint8_t>(scaled[k]);
+      }
+    }
+  }
+  for (; i < count * 3; ++i) {
+    double v = std::min(linear_to_gamma(pixels[i / 3][i % 3]), 0.999);
+    out[i] = static_cast<uint8_t>(256.0 * v);
+  }
+}
+
+// EXR header attribute: name, type name, byte size, then the value bytes
+void append_attribute(std::vector<char>& out, const char* name, const char* type, const std::vector<char>& value) {
+  append_string(out, name);
+  append_string(out, type);
+  append_raw(out, static_cast<int32_t>(value.size()));
+  out.insert(out.end(), value.begin(), value.end());
+}
+
+}
+
+// image_writer method definitions
+std::unique_ptr<image_writer> image_writer::for_path(const std::string& path, int thread_count) {
+  std::unique_ptr<image_writer> writer;
+  if (ends_with(path, ".png")) {
+    writer = std::make_unique<png_writer>();
+  } else if (ends_with(path, ".pfm")) {
+    writer = std::make_unique<pfm_writer>();
+  } else if (ends_with(path, ".exr")) {
+    writer = std::make_unique<exr_writer>();
+  } else {
+    writer = std::make_unique<ppm_writer>();
+  }
+  writer->thread_count = std::max(1, thread_count);
+  return writer;
+}
+
+void image_writer::parallel_rows(int height, const std::function<void(int, int)>& fn) const {
+  const int chunks = std::max(1, std::min(thread_count, height));
+  if (chunks == 1) {
+    trace_span span("encode rows", "io", 0);
+    fn(0, height);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(chunks);
+  for (int c = 0; c < chunks; ++c) {
+    int begin = static_cast<int>(static_cast<long long>(height) * c / chunks);
+    int end = static_cast<int>(static_cast<long long>(height) * (c + 1) / chunks);
+    threads.emplace_back([&fn, c, begin, end]() {
+      timeline::name_thread("encoder " + std::to_string(c));
+      trace_span span("encode rows", "io", c);
+      fn(begin, end);
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+}
+
+void image_writer::to_display_bytes(const color* pixels, size_t count, uint8_t* out) {
+  display_bytes(pixels, count, out);
+}
+
+// ppm_writer method definitions
+bool ppm_writer::write(const std::string& path, int width, int height, const std::vector<color>& pixels) const {
+  std::vector<uint8_t> bytes(static_cast<size_t>(width) * height * 3);
+  parallel_rows(height, [&](int begin, int end) {
+    size_t offset = static_cast<size_t>(begin) * width;
+    to_display_bytes(&pixels[offset], static_cast<size_t>(end - begin) * width, &bytes[offset * 3]);
+  });
+
+  std::ofstream file_out(path, std::ios::binary);
+  file_out << "P6\n" << width << " " << height << "\n" << 255 << "\n";
+  file_out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  return static_cast<bool>(file_out);
+}
+
+// pfm_writer method definitions
+bool pfm_writer::write(const std::string& path, int width, int height, const std::vector<color>& pixels) const {
+  // PFM stores rows bottom to top; a negative scale marks little-endian data.
+  std::vector<float> values(static_cast<size_t>(width) * height * 3);
+  parallel_rows(height, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      const color* src = &pixels[static_cast<size_t>(i) * width];
+      float* dst = &values[static_cast<size_t>(height - 1 - i) * width * 3];
+      for (int j = 0; j < width; ++j) {
+        dst[3 * j + 0] = static_cast<float>(src[j].x());
+        dst[3 * j + 1] = static_cast<float>(src[j].y());
+        dst[3 * j + 2] = static_cast<float>(src[j].z());
+      }
+    }
+  });
+
+  std::ofstream file_out(path, std::ios::binary);
+  file_out << "PF\n" << width << " " << height << "\n-1.0\n";
+  file_out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+  return static_cast<bool>(file_out);
+}
+
+// exr_writer method definitions
+bool exr_writer::write(const std::string& path, int width, int height, const std::vector<color>& pixels) const {
+  std::vector<char> header;
+  const uint8_t magic[4] = {0x76, 0x2f, 0x31, 0x01};
+  header.insert(header.end(), magic, magic + 4);
+  append_raw(header, static_cast<int32_t>(2));  // version 2, single-part scanline file
+
+  // Channels are listed (and stored) in alphabetical order: B, G, R.
+  std::vector<char> channels;
+  for (const char* name : {"B", "G", "R"}) {
+    append_string(channels, name);
+    append_raw(channels, static_cast<int32_t>(2));  // FLOAT
+    append_raw(channels, static_cast<int32_t>(0));  // pLinear + reserved bytes
+    append_raw(channels, static_cast<int32_t>(1));  // x sampling
+    append_raw(channels, static_cast<int32_t>(1));  // y sampling
+  }
+  channels.push_back(0);
+  append_attribute(header, "channels", "chlist", channels);
+  append_attribute(header, "compression", "compression", {0});
+
+  std::vector<char> window;
+  for (int32_t v : {0, 0, width - 1, height - 1}) append_raw(window, v);
+  append_attribute(header, "dataWindow", "box2i", window);
+  append_attribute(header, "displayWindow", "box2i", window);
+  append_attribute(header, "lineOrder", "lineOrder", {0});
+
+  std::vector<char> one;
+  append_raw(one, 1.0f);
+  append_attribute(header, "pixelAspectRatio", "float", one);
+  std::vector<char> center;
+  append_raw(center, 0.0f);
+  append_raw(center, 0.0f);
+  append_attribute(header, "screenWindowCenter", "v2f", center);
+  append_attribute(header, "screenWindowWidth", "float", one);
+  header.push_back(0);
+
+  // Uncompressed files hold one scanline per block: y, byte count, channel planes.
+  const size_t line_bytes = static_cast<size_t>(width) * 3 * sizeof(float);
+  const size_t block_bytes = 2 * sizeof(int32_t) + line_bytes;
+  const uint64_t first_block = header.size() + static_cast<uint64_t>(height) * sizeof(uint64_t);
+
+  std::vector<char> blocks(block_bytes * height);
+  parallel_rows(height, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      char* block = &blocks[block_bytes * i];
+      int32_t y = i;
+      int32_t size = static_cast<int32_t>(line_bytes);
+      std::memcpy(block, &y, sizeof(y));
+      std::memcpy(block + sizeof(y), &size, sizeof(size));
+      float* planes = reinterpret_cast<float*>(block + 2 * sizeof(int32_t));
+      const color* src = &pixels[static_cast<size_t>(i) * width];
+      for (int j = 0; j < width; ++j) {
+        planes[j] = static_cast<float>(src[j].z());
+        planes[width + j] = static_cast<float>(src[j].y());
+        planes[2 * width + j] = static_cast<float>(src[j].x());
+      }
+    }
+  });
+
+  std::ofstream file_out(path, std::ios::binary);
+  file_out.write(header.data(), header.size());
+  for (int i = 0; i < height; ++i) {
+    uint64_t offset = first_block + block_bytes * i;
+    file_out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+  }
+  file_out.write(blocks.data(), blocks.size());
+  return static_cast<bool>(file_out);
+}
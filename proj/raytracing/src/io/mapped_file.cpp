@@ -0,0 +1,44 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <io/mapped_file.hpp>
+
+// mapped_file method definitions
+mapped_file::~mapped_file() {
+  close();
+}
+
+bool mapped_file::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  bytes = static_cast<const unsigned char*>(mapping);
+  length = static_cast<size_t>(info.st_size);
+  return true;
+}
+
+void mapped_file::close() {
+  if (bytes) {
+    munmap(const_cast<unsigned char*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+  }
+}
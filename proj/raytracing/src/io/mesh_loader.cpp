@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <io/mapped_file.hpp>
+#include <io/mesh_loader.hpp>
+
+namespace {
+
+bool has_extension(const std::string& path, const char* extension) {
+  const size_t n = std::strlen(extension);
+  if (path.size() < n) return false;
+  return std::equal(path.end() - n, path.end(), extension, [](char a, char b) {
+    return std::tolower(static_cast<unsigned char>(a)) == b;
+  });
+}
+
+bool is_blank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Cursor over a mapped text file; parsing never reads past end.
+struct text_cursor {
+  const char* p;
+  const char* end;
+
+  void skip_blanks() {
+    while (p < end && is_blank(*p)) ++p;
+  }
+
+  void skip_line() {
+    const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    p = newline ? static_cast<const char*>(newline) + 1 : end;
+  }
+
+  bool at_line_end() const {
+    return p == end || *p == '\n' || *p == '#';
+  }
+
+  template <typename T>
+  bool number(T& value) {
+    skip_blanks();
+    if (p < end && *p == '+') ++p;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+  }
+
+  // Skips the rest of a whitespace-separated token, e.g. "/2/3" after a face index
+  void skip_token() {
+    while (p < end && !is_blank(*p) && *p != '\n') ++p;
+  }
+};
+
+bool load_obj(const std::string& path, const mapped_file& file, std::vector<point3>& vertices,
+              std::vector<uint32_t>& indices) {
+  text_cursor in{reinterpret_cast<const char*>(file.data()), reinterpret_cast<const char*>(file.data()) + file.size()};
+  std::vector<uint32_t> polygon;
+  size_t line = 0;
+
+  auto fail = [&](const char* message) {
+    std::cerr << path << ":" << line << ": " << message << std::endl;
+    return false;
+  };
+
+  while (in.p < in.end) {
+    ++line;
+    in.skip_blanks();
+    const char* start = in.p;
+    if (in.end - start >= 2 && start[0] == 'v' && is_blank(start[1])) {
+      in.p += 2;
+      double x, y, z;
+      if (!in.number(x) || !in.number(y) || !in.number(z)) return fail("expected three vertex coordinates");
+      vertices.emplace_back(x, y, z);
+    } else if (in.end - start >= 2 && start[0] == 'f' && is_blank(start[1])) {
+      in.p += 2;
+      polygon.clear();
+      in.skip_blanks();
+      while (!in.at_line_end()) {
+        long long index;
+        if (!in.number(index)) return fail("bad face index");
+        // 1-based, or negative counting back from the latest vertex
+        long long resolved = index > 0 ? index - 1 : static_cast<long long>(vertices.size()) + index;
+        if (index == 0 || resolved < 0 || resolved >= static_cast<long long>(vertices.size())) {
+          return fail("face index out of range");
+        }
+        polygon.push_back(static_cast<uint32_t>(resolved));
+        in.skip_token();
+        in.skip_blanks();
+      }
+      for (size_t k = 2; k < polygon.size(); ++k) {
+        indices.push_back(polygon[0]);
+        indices.push_back(polygon[k - 1]);
+        indices.push_back(polygon[k]);
+      }
+    }
+    in.skip_line();
+  }
+  return true;
+}
+
+enum class ply_type { int8, uint8, int16, uint16, int32, uint32, float32, float64, invalid };
+
+ply_type parse_ply_type(const std::string& name) {
+  if (name == "char" || name == "int8") return ply_type::int8;
+  if (name == "uchar" || name == "uint8") return ply_type::uint8;
+  if (name == "short" || name == "int16") return ply_type::int16;
+  if (name == "ushort" || name == "uint16") return ply_type::uint16;
+  if (name == "int" || name == "int32") return ply_type::int32;
+  if (name == "uint" || name == "uint32") return ply_type::uint32;
+  if (name == "float" || name == "float32") return ply_type::float32;
+  if (name == "double" || name == "float64") return ply_type::float64;
+  return ply_type::invalid;
+}
+
+size_t ply_type_size(ply_type type) {
+  switch (type) {
+    case ply_type::int8: case ply_type::uint8: return 1;
+    case ply_type::int16: case ply_type::uint16: return 2;
+    case ply_type::int32: case ply_type::uint32: case ply_type::float32: return 4;
+    case ply_type::float64: return 8;
+    default: return 0;
+  }
+}
+
+struct ply_property {
+  std::string name;
+  ply_type type = ply_type::invalid;
+  // Lists store a count of count_type, then that many values of type.
+  bool is_list = false;
+  ply_type count_type = ply_type::invalid;
+};
+
+struct ply_element {
+  std::string name;
+  size_t count = 0;
+  std::vector<ply_property> properties;
+};
+
+// Reads PLY property values from the body, binary (either byte order) or ASCII.
+struct ply_reader {
+  const unsigned char* p;
+  const unsigned char* end;
+  bool ascii;
+  bool swap_bytes;
+
+  size_t remaining() const { return static_cast<size_t>(end - p); }
+
+  // Fewest bytes a record of element can take: its binary size, with lists
+  // empty, or one character per value in ASCII.
+  size_t min_record_size(const ply_element& element) const {
+    size_t size = 0;
+    for (const ply_property& property : element.properties) {
+      size += ascii ? 1 : ply_type_size(property.is_list ? property.count_type : property.type);
+    }
+    return size;
+  }
+
+  bool value(ply_type type, double& out) {
+    if (ascii) {
+      text_cursor in{reinterpret_cast<const char*>(p), reinterpret_cast<const char*>(end)};
+      while (in.p < in.end && (is_blank(*in.p) || *in.p == '\n')) ++in.p;
+      if (!in.number(out)) return false;
+      p = reinterpret_cast<const unsigned char*>(in.p);
+      return true;
+    }
+
+    const size_t size = ply_type_size(type);
+    if (size == 0 || static_cast<size_t>(end - p) < size) return false;
+    const unsigned char* bytes = p;
+    p += size;
+
+    switch (type) {
+      case ply_type::int8: out = static_cast<int8_t>(bytes[0]); break;
+      case ply_type::uint8: out = bytes[0]; break;
+      case ply_type::int16: out = static_cast<int16_t>(load16(bytes)); break;
+      case ply_type::uint16: out = load16(bytes); break;
+      case ply_type::int32: out = static_cast<int32_t>(load32(bytes)); break;
+      case ply_type::uint32: out = load32(bytes); break;
+      case ply_type::float32: { const uint32_t bits = load32(bytes); float v; std::memcpy(&v, &bits, 4); out = v; break; }
+      case ply_type::float64: { const uint64_t bits = load64(bytes); double v; std::memcpy(&v, &bits, 8); out = v; break; }
+      default: return false;
+    }
+    return true;
+  }
+
+  // Unaligned loads in the file's byte order
+  uint16_t load16(const unsigned char* bytes) const {
+    uint16_t v;
+    std::memcpy(&v, bytes, 2);
+    return swap_bytes ? __builtin_bswap16(v) : v;
+  }
+
+  uint32_t load32(const unsigned char* bytes) const {
+    uint32_t v;
+    std::memcpy(&v, bytes, 4);
+    return swap_bytes ? __builtin_bswap32(v) : v;
+  }
+
+  uint64_t load64(const unsigned char* bytes) const {
+    uint64_t v;
+    std::memcpy(&v, bytes, 8);
+    return swap_bytes ? __builtin_bswap64(v) : v;
+  }
+};
+
+// Whether a value read from the file is a whole number in [0, end), so it can be
+// converted to an unsigned type
+bool is_index(double value, double end) {
+  return std::isfinite(value) && value >= 0 && value < end && value == std::floor(value);
+}
+
+bool host_is_little_endian() {
+  const uint16_t probe = 1;
+  unsigned char first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+bool load_ply(const std::string& path, const mapped_file& file, std::vector<point3>& vertices,
+              std::vector<uint32_t>& indices) {
+  auto fail = [&](const std::string& message) {
+    std::cerr << path << ": " << message << std::endl;
+    return false;
+  };
+
+  // Header: text lines up to and including "end_header"
+  const char* text = reinterpret_cast<const char*>(file.data());
+  const char* text_end = text + file.size();
+  std::vector<ply_element> elements;
+  std::string format;
+  bool header_done = false;
+  const char* line_start = text;
+
+  while (line_start < text_end && !header_done) {
+    const char* line_end = static_cast<const char*>(std::memchr(line_start, '\n', text_end - line_start));
+    if (!line_end) return fail("truncated PLY header");
+    std::string line(line_start, line_end);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    line_start = line_end + 1;
+
+    std::vector<std::string> words;
+    size_t pos = 0;
+    while (pos < line.size()) {
+      size_t next = line.find(' ', pos);
+      if (next == std::string::npos) next = line.size();
+      if (next > pos) words.push_back(line.substr(pos, next - pos));
+      pos = next + 1;
+    }
+    if (words.empty()) continue;
+
+    if (words[0] == "format" && words.size() >= 2) {
+      format = words[1];
+    } else if (words[0] == "element" && words.size() >= 3) {
+      ply_element element;
+      element.name = words[1];
+      const std::string& count = words[2];
+      auto result = std::from_chars(count.data(), count.data() + count.size(), element.count);
+      if (result.ec != std::errc() || result.ptr != count.data() + count.size()) {
+        return fail("bad PLY element count '" + line + "'");
+      }
+      elements.push_back(element);
+    } else if (words[0] == "property" && !elements.empty()) {
+      ply_property property;
+      if (words.size() >= 5 && words[1] == "list") {
+        property.is_list = true;
+        property.count_type = parse_ply_type(words[2]);
+        property.type = parse_ply_type(words[3]);
+        property.name = words[4];
+      } else if (words.size() >= 3) {
+        property.type = parse_ply_type(words[1]);
+        property.name = words[2];
+      }
+      if (property.type == ply_type::invalid || (property.is_list && property.count_type == ply_type::invalid)) {
+        return fail("unsupported PLY property '" + line + "'");
+      }
+      elements.back().properties.push_back(property);
+    } else if (words[0] == "end_header") {
+      header_done = true;
+    }
+  }
+  if (!header_done) return fail("missing end_header");
+
+  ply_reader in{reinterpret_cast<const unsigned char*>(line_start), file.data() + file.size(), false, false};
+  if (format == "ascii") {
+    in.ascii = true;
+  } else if (format == "binary_little_endian") {
+    in.swap_bytes = !host_is_little_endian();
+  } else if (format == "binary_big_endian") {
+    in.swap_bytes = host_is_little_endian();
+  } else {
+    return fail("unknown PLY format '" + format + "'");
+  }
+
+  std::vector<uint32_t> polygon;
+  for (const ply_element& element : elements) {
+    const bool is_vertex = element.name == "vertex";
+    const bool is_face = element.name == "face";
+    // Which property feeds x, y, z (vertices) or the index list (faces)
+    int slot_of[3] = {-1, -1, -1};
+    int index_list = -1;
+    for (size_t k = 0; k < element.properties.size(); ++k) {
+      const std::string& name = element.properties[k].name;
+      if (is_vertex && name.size() == 1 && name[0] >= 'x' && name[0] <= 'z') slot_of[name[0] - 'x'] = static_cast<int>(k);
+      if (is_face && (name == "vertex_indices" || name == "vertex_index")) index_list = static_cast<int>(k);
+    }
+    if (is_vertex && (slot_of[0] < 0 || slot_of[1] < 0 || slot_of[2] < 0)) return fail("vertex element without x, y, z");
+    // Counts come from the header; a count the remaining bytes cannot hold means
+    // a truncated or corrupt file, and must not size an allocation.
+    const size_t record_size = in.min_record_size(element);
+    if (record_size == 0) continue;
+    if (element.count > in.remaining() / record_size) return fail("truncated PLY data");
+    if (is_vertex) vertices.reserve(vertices.size() + element.count);
+
+    for (size_t item = 0; item < element.count; ++item) {
+      double position[3] = {0, 0, 0};
+      for (size_t k = 0; k < element.properties.size(); ++k) {
+        const ply_property& property = element.properties[k];
+        double value;
+        if (!property.is_list) {
+          if (!in.value(property.type, value)) return fail("truncated PLY data");
+          for (int axis = 0; axis < 3; ++axis) {
+            if (slot_of[axis] == static_cast<int>(k)) position[axis] = value;
+          }
+          continue;
+        }
+
+        double count;
+        if (!in.value(property.count_type, count)) return fail("truncated PLY data");
+        if (!is_index(count, static_cast<double>(in.remaining()) + 1)) return fail("bad PLY list count");
+        const bool wanted = static_cast<int>(k) == index_list;
+        polygon.clear();
+        for (size_t n = 0; n < static_cast<size_t>(count); ++n) {
+          if (!in.value(property.type, value)) return fail("truncated PLY data");
+          if (!wanted) continue;
+          if (!is_index(value, static_cast<double>(vertices.size()))) return fail("face index out of range");
+          polygon.push_back(static_cast<uint32_t>(value));
+        }
+        if (wanted) {
+          for (size_t n = 2; n < polygon.size(); ++n) {
+            indices.push_back(polygon[0]);
+            indices.push_back(polygon[n - 1]);
+            indices.push_back(polygon[n]);
+          }
+        }
+      }
+      if (is_vertex) vertices.emplace_back(position[0], position[1], position[2]);
+    }
+  }
+  return true;
+}
+
+}
+
+bool load_mesh(const std::string& path, std::vector<point3>& vertices, std::vector<uint32_t>& indices) {
+  mapped_file file;
+  if (!file.open(path)) {
+    std::cerr << path << ": cannot open mesh" << std::endl;
+    return false;
+  }
+
+  vertices.clear();
+  indices.clear();
+  if (has_extension(path, ".obj")) {
+    return load_obj(path, file, vertices, indices);
+  }
+  if (has_extension(path, ".ply")) {
+    return load_ply(path, file, vertices, indices);
+  }
+  std::cerr << path << ": unknown mesh format (expected .obj or .ply)" << std::endl;
+  return false;
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#include <io/deflate.hpp>
+#include <io/image_writer.hpp>
+
+namespace {
+
+constexpr int bytes_per_pixel = 3;
+
+uint8_t paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = std::abs(p - a);
+  int pb = std::abs(p - b);
+  int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+  if (pb <= pc) return static_cast<uint8_t>(b);
+  return static_cast<uint8_t>(c);
+}
+
+// Applies one of the five PNG filter types to a scanline (prev is null for row 0).
+void filter_row(int type, const uint8_t* row, const uint8_t* prev, size_t length, uint8_t* out) {
+  for (size_t x = 0; x < length; ++x) {
+    int left = x >= bytes_per_pixel ? row[x - bytes_per_pixel] : 0;
+    int up = prev ? prev[x] : 0;
+    int up_left = (prev && x >= bytes_per_pixel) ? prev[x - bytes_per_pixel] : 0;
+    int predicted = 0;
+    switch (type) {
+      case 1: predicted = left; break;
+      case 2: predicted = up; break;
+      case 3: predicted = (left + up) / 2; break;
+      case 4: predicted = paeth(left, up, up_left); break;
+      default: break;
+    }
+    out[x] = static_cast<uint8_t>(row[x] - predicted);
+  }
+}
+
+void append_be32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+void append_chunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data) {
+  append_be32(out, static_cast<uint32_t>(data.size()));
+  size_t type_start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  append_be32(out, crc32(&out[type_start], out.size() - type_start));
+}
+
+}
+
+// png_writer method definitions
+bool png_writer::write(const std::string& path, int width, int height, const std::vector<color>& pixels) const {
+  const size_t row_bytes = static_cast<size_t>(width) * bytes_per_pixel;
+  const size_t stride = row_bytes + 1;
+
+  std::vector<uint8_t> rgb(row_bytes * height);
+  parallel_rows(height, [&](int begin, int end) {
+    size_t offset = static_cast<size_t>(begin) * width;
+    to_display_bytes(&pixels[offset], static_cast<size_t>(end - begin) * width, &rgb[offset * bytes_per_pixel]);
+  });
+
+  // Filter each scanline with whichever filter minimizes the sum of absolute
+  // residuals (the usual libpng heuristic).
+  std::vector<uint8_t> filtered(stride * height);
+  parallel_rows(height, [&](int begin, int end) {
+    std::vector<uint8_t> candidate(row_bytes);
+    for (int i = begin; i < end; ++i) {
+      const uint8_t* row = &rgb[row_bytes * i];
+      const uint8_t* prev = i > 0 ? &rgb[row_bytes * (i - 1)] : nullptr;
+      uint8_t* out = &filtered[stride * i];
+      long best_score = -1;
+      for (int type = 0; type < 5; ++type) {
+        filter_row(type, row, prev, row_bytes, candidate.data());
+        long score = 0;
+        for (uint8_t v : candidate) score += v < 128 ? v : 256 - v;
+        if (best_score < 0 || score < best_score) {
+          best_score = score;
+          out[0] = static_cast<uint8_t>(type);
+          std::copy(candidate.begin(), candidate.end(), out + 1);
+        }
+      }
+    }
+  });
+
+  // Deflate row chunks independently and concatenate them into one zlib stream.
+  const int chunks = std::max(1, std::min(thread_count, height));
+  std::vector<std::vector<uint8_t>> compressed(chunks);
+  std::vector<uint32_t> chunk_adler(chunks);
+  std::vector<size_t> chunk_size(chunks);
+  parallel_rows(chunks, [&](int begin, int end) {
+    for (int c = begin; c < end; ++c) {
+      size_t first = stride * (static_cast<long long>(height) * c / chunks);
+      size_t last = stride * (static_cast<long long>(height) * (c + 1) / chunks);
+      compressed[c] = deflate_chunk(filtered.data() + first, last - first, c == chunks - 1);
+      chunk_adler[c] = adler32(filtered.data() + first, last - first);
+      chunk_size[c] = last - first;
+    }
+  });
+
+  std::vector<uint8_t> zlib_stream = {0x78, 0x01};
+  uint32_t adler = 1;
+  for (int c = 0; c < chunks; ++c) {
+    zlib_stream.insert(zlib_stream.end(), compressed[c].begin(), compressed[c].end());
+    adler = adler32_combine(adler, chunk_adler[c], chunk_size[c]);
+  }
+  append_be32(zlib_stream, adler);
+
+  std::vector<uint8_t> ihdr;
+  append_be32(ihdr, static_cast<uint32_t>(width));
+  append_be32(ihdr, static_cast<uint32_t>(height));
+  ihdr.push_back(8);  // bit depth
+  ihdr.push_back(2);  // color type: truecolor RGB
+  ihdr.push_back(0);  // compression: deflate
+  ihdr.push_back(0);  // filter method: adaptive
+  ihdr.push_back(0);  // no interlace
+
+  const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  std::vector<uint8_t> file(signature, signature + 8);
+  append_chunk(file, "IHDR", ihdr);
+  append_chunk(file, "IDAT", zlib_stream);
+  append_chunk(file, "IEND", {});
+
+  std::ofstream file_out(path, std::ios::binary);
+  file_out.write(reinterpret_cast<const char*>(file.data()), file.size());
+  return static_cast<bool>(file_out);
+}
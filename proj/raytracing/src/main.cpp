@@ -1,47 +1,170 @@
 #include <iostream>
-#include <memory>
+#include <string>
 
+#include <objects/bvh.hpp>
 #include <objects/camera.hpp>
-#include <objects/color.hpp>
-#include <objects/hittable.hpp>
 
-#include <shapes/sphere.hpp>
-#include <shapes/box.hpp>
+#include <render/timeline.hpp>
 
-#include <materials/lambertian.hpp>
-#include <materials/metal.hpp>
-#include <materials/dielectric.hpp>
+#include <scene/scene.hpp>
 
-signed main() {
-  hittable_list world;
+signed main(int argc, char** argv) {
+  // Usage: raytracing [scene file] [options]
+  std::string scene_path = "./scenes/default.scene";
+  std::string output_path = "./images/out.png";
+  int first_option = 1;
+  if (argc > 1 && std::string(argv[1]).rfind("--", 0) != 0) {
+    scene_path = argv[1];
+    first_option = 2;
+  }
+  std::string trace_path;
+  for (int k = first_option; k + 1 < argc; k += 2) {
+    if (std::string(argv[k]) == "--output") {
+      output_path = argv[k + 1];
+    } else if (std::string(argv[k]) == "--trace") {
+      trace_path = argv[k + 1];
+    }
+  }
+  if (!trace_path.empty()) {
+    timeline::start();
+  }
 
-  auto material_ground = std::make_shared<lambertian>(color(0.11, 0.14, 0.22));
-  auto material_center = std::make_shared<lambertian>(color(0.9, 0.1, 0.1));
-  auto material_side = std::make_shared<metal>(color(1.0, 1.0, 1.0), 0.0);
-  auto material_glass = std::make_shared<dielectric>(1.5);
+  scene world;
+  if (!world.load(scene_path)) {
+    return 1;
+  }
 
-  // Scene objects: glass center, metals, small diffuse sphere, ground sphere, and background box
-      world.add(std::make_shared<sphere>(point3(0, 0, -1), 0.5, material_glass));
-// Removed right sphere at (1, 0, -1)
-      world.add(std::make_shared<sphere>(point3(-1, 0, -1), 0.5, material_side));
-      world.add(std::make_shared<sphere>(point3(0, -0.25, -2), 0.25, material_center));
-      world.add(std::make_shared<sphere>(point3(0, -100.5, -1), 100, material_ground));
-      // world.add(std::make_shared<box>(point3(-1.25, -0.5, -3.25), point3(1.25, 1.25, -2.25), material_center));
-      // world.add(std::make_shared<box>(point3(0.3, -0.2, -3.6), point3(1.0, 0.8, -2.8), material_center));
-      world.add(std::make_shared<box>(point3(0.5, -0.25, -3.5), point3(5.0, 0.35, -2.9), material_center));
+  camera cam(output_path);
+  world.view.apply(cam);
+  cam.scene_fingerprint = world.fingerprint;
 
+  // Command line overrides of the scene's camera:
+  //   --output F       image to write (.png, .pfm, .exr, otherwise PPM)
+  //   --width N        image width in pixels (height follows the aspect ratio)
+  //   --spp N          total samples per pixel
+  //   --pass N         samples per progressive pass; checkpoints are saved between passes,
+  //                    so this bounds the work a preempted run loses (default 16 with
+  //                    --checkpoint, otherwise the whole render is one pass)
+  //   --checkpoint F   save progress to F and resume from it on the next run
+  //   --adaptive T     adaptive sampling with noise threshold T, capped at --spp
+  //   --min-spp N      samples every pixel takes before adaptive sampling may stop it
+  //   --sample-map F   write the per-pixel sample counts to F (PGM)
+  //   --depth N        maximum number of rays per path
+  //   --roulette N     bounces before Russian roulette may end a path (0 = never)
+  //   --integrator I   recursive (default) or wavefront
+  //   --packets on|off trace primary rays in 4x4 packets (recursive integrator only)
+  //   --seed N         seed of the random streams; a seed always renders the same image
+  //   --sampler S      independent (default), stratified, sobol or bluenoise
+  //   --threads N      worker threads (default: one per hardware thread)
+  //   --tile-size N    edge length in pixels of the square tiles threads take turns on
+  //   --tiles I/N      render only part I (0-based) of N tile sets, for distributed runs
+  //   --partial F      write the sums and sample counts to F instead of an image; parts
+  //                    of one frame (different --tiles, or different --seed for extra
+  //                    samples of the same pixels) are combined with the merge tool
+  //   --stats F        write render statistics to F as JSON (RAYTRACING_STATS builds)
+  //   --trace F        write a timeline of the run to F (Chrome trace JSON, for
+  //                    chrome://tracing or ui.perfetto.dev)
+  //   --denoise on|off run the edge-aware denoiser before writing the image
+  //   --aov PREFIX     write albedo, normal and depth buffers to PREFIX.*.pfm
+  for (int k = first_option; k + 1 < argc; k += 2) {
+    std::string option = argv[k];
+    std::string value = argv[k + 1];
+    if (option == "--output" || option == "--trace") {
+      continue;
+    } else if (option == "--width") {
+      cam.image_width = std::stoi(value);
+    } else if (option == "--spp") {
+      cam.samples_per_pixel = std::stoi(value);
+    } else if (option == "--pass") {
+      cam.samples_per_pass = std::stoi(value);
+    } else if (option == "--checkpoint") {
+      cam.checkpoint_path = value;
+    } else if (option == "--adaptive") {
+      cam.adaptive_threshold = std::stod(value);
+    } else if (option == "--min-spp") {
+      cam.adaptive_min_samples = std::stoi(value);
+    } else if (option == "--sample-map") {
+      cam.sample_map_path = value;
+    } else if (option == "--depth") {
+      cam.max_depth = std::stoi(value);
+    } else if (option == "--roulette") {
+      cam.roulette_depth = std::stoi(value);
+    } else if (option == "--integrator") {
+      if (value != "recursive" && value != "wavefront") {
+        std::cerr << "Unknown integrator " << value << std::endl;
+        return 1;
+      }
+      cam.use_wavefront = value == "wavefront";
+    } else if (option == "--packets") {
+      if (value != "on" && value != "off") {
+        std::cerr << "Expected --packets on|off" << std::endl;
+        return 1;
+      }
+      cam.use_ray_packets = value == "on";
+    } else if (option == "--seed") {
+      cam.seed = std::stoull(value);
+    } else if (option == "--sampler") {
+      if (!sampler::parse(value, cam.sampling)) {
+        std::cerr << "Unknown sampler " << value << std::endl;
+        return 1;
+      }
+    } else if (option == "--threads") {
+      cam.thread_count = std::stoi(value);
+      if (cam.thread_count < 1) {
+        std::cerr << "Expected --threads N with N >= 1" << std::endl;
+        return 1;
+      }
+    } else if (option == "--tile-size") {
+      cam.tile_size = std::stoi(value);
+      if (cam.tile_size < 1) {
+        std::cerr << "Expected --tile-size N with N >= 1" << std::endl;
+        return 1;
+      }
+    } else if (option == "--tiles") {
+      const size_t slash = value.find('/');
+      if (slash == std::string::npos) {
+        std::cerr << "Expected --tiles I/N" << std::endl;
+        return 1;
+      }
+      cam.tile_part = std::stoi(value.substr(0, slash));
+      cam.tile_part_count = std::stoi(value.substr(slash + 1));
+      if (cam.tile_part_count < 1 || cam.tile_part < 0 || cam.tile_part >= cam.tile_part_count) {
+        std::cerr << "Bad tile part " << value << std::endl;
+        return 1;
+      }
+    } else if (option == "--partial") {
+      cam.partial_path = value;
+    } else if (option == "--stats") {
+      if (!render_stats::enabled()) {
+        std::cerr << "Statistics are not compiled in; configure with -DRAYTRACING_STATS=ON" << std::endl;
+      }
+      cam.stats_path = value;
+    } else if (option == "--denoise") {
+      if (value != "on" && value != "off") {
+        std::cerr << "Expected --denoise on|off" << std::endl;
+        return 1;
+      }
+      cam.denoise = value == "on";
+    } else if (option == "--aov") {
+      cam.aov_path = value;
+    } else {
+      std::cerr << "Unknown option " << option << std::endl;
+      return 1;
+    }
+  }
 
-  camera cam("./images/out.ppm");
+  bvh accelerator(world.world);
+  cam.render(accelerator, world.materials, &world.lights);
 
-  // adjust camera parameters here
-  cam.aspect_ratio = 16.0 / 9.0;
-  cam.image_width = 1920;
-  cam.samples_per_pixel = 100;
-  cam.max_depth = 5;
+  if (!trace_path.empty() && !timeline::write(trace_path)) {
+    std::cerr << "Failed to write " << trace_path << std::endl;
+  }
 
-  cam.render(world);
-
-  std::cout << "\nImage rendered to ./images/out.ppm" << std::endl;
+  if (cam.partial_path.empty()) {
+    std::cout << "\nImage rendered to " << output_path << std::endl;
+  } else {
+    std::cout << "\nPartial buffer written to " << cam.partial_path << std::endl;
+  }
 
   return 0;
 }
@@ -1,7 +1,18 @@
+#include <cmath>
+
 #include <materials/lambertian.hpp>
 
+#include <constants.hpp>
+#include <randomizer.hpp>
+
+#include <objects/sampling.hpp>
+
 bool lambertian::scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const {
-  vec3 scatter_direction = rec.normal + random_unit_vector();
+  // The normal plus a uniform point on the unit sphere is distributed as
+  // cos(theta) / pi, without building a basis around the normal.
+  double u[2];
+  thread_rng().fill(u, 2);
+  vec3 scatter_direction = rec.normal + sample_uniform_sphere(u[0], u[1]).value;
 
   if(scatter_direction.near_zero()) {
     scatter_direction = rec.normal;
@@ -10,4 +21,13 @@ bool lambertian::scatter(const ray& r_in, const hit_record& rec, color& attenuat
   scattered = ray(rec.p, scatter_direction);
   attenuation = albedo;
   return true;
-}
\ No newline at end of file
+}
+
+color lambertian::evaluate(const ray& r_in, const hit_record& rec, const vec3& direction) const {
+  return albedo * scattering_pdf(r_in, rec, direction);
+}
+
+// Density of the directions scatter() picks
+double lambertian::scattering_pdf(const ray&, const hit_record& rec, const vec3& direction) const {
+  return cosine_hemisphere_pdf(dot(rec.normal, unit_vector(direction)));
+}
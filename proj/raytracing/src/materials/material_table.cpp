@@ -0,0 +1,7 @@
+#include <materials/material_table.hpp>
+
+// material_table method definitions
+material_id material_table::add(std::unique_ptr<material> mat) {
+  materials.push_back(std::move(mat));
+  return static_cast<material_id>(materials.size() - 1);
+}
@@ -1,4 +1,9 @@
 #include <materials/metal.hpp>
+
+#include <randomizer.hpp>
+
+#include <objects/sampling.hpp>
+
 // reflect helper is intentionally defined with external linkage so other materials (e.g. dielectric) can reuse it.
 // Consider moving this to a shared header (e.g. a vec_utils.hpp) if broader reuse is needed.
 
@@ -9,7 +14,9 @@ vec3 reflect(const vec3& v, const vec3& n) {
 
 bool metal::scatter(const ray& r_in, const hit_record& rec, color& attenuation, ray& scattered) const {
   vec3 reflected = reflect(unit_vector(r_in.direction()), rec.normal);
-  reflected = unit_vector(reflected) + (fuzz * random_unit_vector());
+  double u[2];
+  thread_rng().fill(u, 2);
+  reflected = unit_vector(reflected) + (fuzz * sample_uniform_sphere(u[0], u[1]).value);
   scattered = ray(rec.p, reflected);
   attenuation = albedo;
   return dot(scattered.direction(), rec.normal) > 0;
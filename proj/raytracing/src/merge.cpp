@@ -0,0 +1,95 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <io/image_writer.hpp>
+
+#include <render/accumulation_buffer.hpp>
+
+// Combines the partial buffers of a distributed render (raytracing --partial) into
+// one image. Parts may cover different tiles (--tiles), the same pixels with
+// different seeds, or both: sums and sample counts simply add up. Parts that
+// repeat samples already merged (the same file twice, or the same tiles and
+// sample numbers of the same seed) are rejected, as they would bias the mean.
+signed main(int argc, char** argv) {
+  // Usage: merge [--buffer F] <image> <partial>...
+  //   --buffer F   also save the merged sums and counts to F, e.g. to merge in stages
+  //                or to resume rendering from it with --checkpoint
+  std::string buffer_path;
+  std::vector<std::string> paths;
+  for (int k = 1; k < argc; ++k) {
+    std::string arg = argv[k];
+    if (arg == "--buffer" && k + 1 < argc) {
+      buffer_path = argv[++k];
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.size() < 2) {
+    std::cerr << "Usage: merge [--buffer F] <image> <partial>..." << std::endl;
+    return 1;
+  }
+
+  const std::string output_path = paths[0];
+  accumulation_buffer merged;
+  uint64_t fingerprint = 0;
+  // File each of merged's streams came from
+  std::vector<size_t> stream_source;
+  for (size_t k = 1; k < paths.size(); ++k) {
+    accumulation_buffer part;
+    uint64_t part_fingerprint = 0;
+    if (!part.read(paths[k], part_fingerprint)) {
+      std::cerr << paths[k] << ": not a partial buffer" << std::endl;
+      return 1;
+    }
+    if (k == 1) {
+      merged = std::move(part);
+      fingerprint = part_fingerprint;
+      stream_source.assign(merged.streams.size(), k);
+      continue;
+    }
+    if (part.width != merged.width || part.height != merged.height || part_fingerprint != fingerprint) {
+      std::cerr << paths[k] << ": rendered with a different camera or resolution than " << paths[1] << std::endl;
+      return 1;
+    }
+    for (const sample_stream& stream : part.streams) {
+      for (size_t s = 0; s < merged.streams.size(); ++s) {
+        if (stream.overlaps(merged.streams[s])) {
+          std::cerr << paths[k] << ": holds samples " << stream.first_sample << ".." << stream.end_sample
+                    << " of seed " << stream.seed << " that " << paths[stream_source[s]] << " already has"
+                    << std::endl;
+          return 1;
+        }
+      }
+    }
+    stream_source.insert(stream_source.end(), part.streams.size(), k);
+    merged.merge(part);
+  }
+
+  const int total_pixels = merged.width * merged.height;
+  int missing = 0;
+  std::vector<color> framebuffer(total_pixels);
+  for (int index = 0; index < total_pixels; ++index) {
+    missing += merged.sample_count[index] == 0;
+    framebuffer[index] = merged.resolve(index);
+  }
+  if (missing > 0) {
+    std::cerr << "Warning: " << missing << " of " << total_pixels << " pixels have no samples" << std::endl;
+  }
+
+  if (!buffer_path.empty() && !merged.save(buffer_path, fingerprint)) {
+    std::cerr << "Failed to write " << buffer_path << std::endl;
+    return 1;
+  }
+
+  const unsigned hw = std::thread::hardware_concurrency();
+  if (!image_writer::for_path(output_path, hw == 0 ? 4 : static_cast<int>(hw))->write(output_path, merged.width,
+                                                                                      merged.height, framebuffer)) {
+    std::cerr << "Failed to write " << output_path << std::endl;
+    return 1;
+  }
+
+  std::cout << "Merged " << paths.size() - 1 << " parts into " << output_path << std::endl;
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include <cmath>
+#include <utility>
+
+#include <objects/aabb.hpp>
+
+// aabb method definitions
+aabb::aabb(const interval& _x, const interval& _y, const interval& _z): x(_x), y(_y), z(_z) {
+  pad_to_minimums();
+}
+
+aabb::aabb(const point3& a, const point3& b) {
+  x = (a[0] <= b[0]) ? interval(a[0], b[0]) : interval(b[0], a[0]);
+  y = (a[1] <= b[1]) ? interval(a[1], b[1]) : interval(b[1], a[1]);
+  z = (a[2] <= b[2]) ? interval(a[2], b[2]) : interval(b[2], a[2]);
+  pad_to_minimums();
+}
+
+aabb::aabb(const aabb& box0, const aabb& box1) {
+  x = interval(box0.x, box1.x);
+  y = interval(box0.y, box1.y);
+  z = interval(box0.z, box1.z);
+}
+
+point3 aabb::centroid() const {
+  return point3(0.5 * (x.min + x.max), 0.5 * (y.min + y.max), 0.5 * (z.min + z.max));
+}
+
+int aabb::longest_axis() const {
+  if (x.size() > y.size()) {
+    return x.size() > z.size() ? 0 : 2;
+  }
+  return y.size() > z.size() ? 1 : 2;
+}
+
+double aabb::surface_area() const {
+  double dx = x.size();
+  double dy = y.size();
+  double dz = z.size();
+  if (dx < 0 || dy < 0 || dz < 0) {
+    return 0;
+  }
+  return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+bool aabb::is_bounded() const {
+  return std::isfinite(x.min) && std::isfinite(x.max) &&
+         std::isfinite(y.min) && std::isfinite(y.max) &&
+         std::isfinite(z.min) && std::isfinite(z.max);
+}
+
+bool aabb::hit(const ray& r, interval ray_interval) const {
+  const point3& origin = r.origin();
+  const vec3& direction = r.direction();
+
+  for (int axis = 0; axis < 3; ++axis) {
+    const interval& slab = axis_interval(axis);
+    real inv_dir = 1 / direction[axis];
+
+    real t0 = (slab.min - origin[axis]) * inv_dir;
+    real t1 = (slab.max - origin[axis]) * inv_dir;
+    if (t0 > t1) std::swap(t0, t1);
+
+    // Comparisons are written so a NaN (0 * inf for a ray lying on a slab plane)
+    // leaves the running interval untouched.
+    if (t0 > ray_interval.min) ray_interval.min = t0;
+    if (t1 < ray_interval.max) ray_interval.max = t1;
+
+    if (ray_interval.max < ray_interval.min) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void aabb::pad_to_minimums() {
+  const real delta = 0.0001;
+  if (x.size() < delta) x = x.expand(delta);
+  if (y.size() < delta) y = y.expand(delta);
+  if (z.size() < delta) z = z.expand(delta);
+}
+
+// Built from INF directly rather than interval::empty/universe, whose initialization
+// order relative to this translation unit is unspecified.
+const aabb aabb::empty = aabb(interval(INF, -INF), interval(INF, -INF), interval(INF, -INF));
+const aabb aabb::universe = aabb(interval(-INF, INF), interval(-INF, INF), interval(-INF, INF));
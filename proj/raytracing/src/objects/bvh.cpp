@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <numeric>
+
+#include <objects/bvh.hpp>
+
+#include <render/timeline.hpp>
+
+namespace {
+
+constexpr int sah_bins = 16;
+constexpr uint32_t max_leaf_size = 4;
+// Leaves are never larger than this, even when SAH says splitting does not pay off.
+constexpr uint32_t max_leaf_size_hard = 16;
+// Relative cost of one node traversal step against one primitive intersection.
+constexpr double traversal_cost = 1.0;
+
+}
+
+// Plain corners instead of aabb: building grows boxes hundreds of millions of times
+// for large meshes, and this keeps every grow and area computation inline.
+struct bvh_tree::build_box {
+  double lo[3] = {INF, INF, INF};
+  double hi[3] = {-INF, -INF, -INF};
+
+  build_box() {}
+  explicit build_box(const aabb& box) {
+    for (int axis = 0; axis < 3; ++axis) {
+      lo[axis] = box.axis_interval(axis).min;
+      hi[axis] = box.axis_interval(axis).max;
+    }
+  }
+
+  void grow(const build_box& b) {
+    for (int axis = 0; axis < 3; ++axis) {
+      lo[axis] = lo[axis] <= b.lo[axis] ? lo[axis] : b.lo[axis];
+      hi[axis] = hi[axis] >= b.hi[axis] ? hi[axis] : b.hi[axis];
+    }
+  }
+
+  void grow(const point3& p) {
+    for (int axis = 0; axis < 3; ++axis) {
+      lo[axis] = lo[axis] <= p[axis] ? lo[axis] : p[axis];
+      hi[axis] = hi[axis] >= p[axis] ? hi[axis] : p[axis];
+    }
+  }
+
+  // Same as aabb::surface_area
+  double surface_area() const {
+    double dx = hi[0] - lo[0];
+    double dy = hi[1] - lo[1];
+    double dz = hi[2] - lo[2];
+    if (dx < 0 || dy < 0 || dz < 0) {
+      return 0;
+    }
+    return 2.0 * (dx * dy + dy * dz + dz * dx);
+  }
+
+  aabb to_aabb() const {
+    return aabb(interval(lo[0], hi[0]), interval(lo[1], hi[1]), interval(lo[2], hi[2]));
+  }
+};
+
+// bvh_tree method definitions
+void bvh_tree::build(const std::vector<aabb>& primitive_boxes) {
+  trace_span span("build bvh", "scene");
+  const uint32_t primitive_count = static_cast<uint32_t>(primitive_boxes.size());
+
+  nodes.clear();
+  indices.resize(primitive_count);
+  std::iota(indices.begin(), indices.end(), 0u);
+  if (primitive_count == 0) {
+    return;
+  }
+
+  std::vector<build_box> boxes;
+  std::vector<point3> centroids;
+  boxes.reserve(primitive_count);
+  centroids.reserve(primitive_count);
+  for (const auto& box : primitive_boxes) {
+    boxes.emplace_back(box);
+    centroids.push_back(box.centroid());
+  }
+
+  nodes.reserve(2 * primitive_count);
+  build_recursive(boxes, centroids, 0, primitive_count, 0);
+  nodes.shrink_to_fit();
+}
+
+aabb bvh_tree::bounds() const {
+  return nodes.empty() ? aabb::empty : nodes[0].box;
+}
+
+uint32_t bvh_tree::build_recursive(const std::vector<build_box>& primitive_boxes, const std::vector<point3>& centroids,
+                                   uint32_t begin, uint32_t end, int depth) {
+  const uint32_t node_index = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+
+  build_box bounds;
+  build_box centroid_bounds;
+  for (uint32_t i = begin; i < end; ++i) {
+    bounds.grow(primitive_boxes[indices[i]]);
+    centroid_bounds.grow(centroids[indices[i]]);
+  }
+  nodes[node_index].box = bounds.to_aabb();
+
+  const uint32_t count = end - begin;
+  auto make_leaf = [&]() {
+    nodes[node_index].offset = begin;
+    nodes[node_index].count = static_cast<uint16_t>(count);
+    return node_index;
+  };
+
+  if (count <= 1) {
+    return make_leaf();
+  }
+
+  // Find the cheapest binned SAH split over all three axes.
+  int best_axis = -1;
+  int best_split = 0;
+  double best_cost = INF;
+  const double parent_area = bounds.surface_area();
+
+  for (int axis = 0; axis < 3 && depth < max_depth; ++axis) {
+    const double extent_min = centroid_bounds.lo[axis];
+    const double extent_size = centroid_bounds.hi[axis] - centroid_bounds.lo[axis];
+    if (extent_size <= 0) {
+      continue;
+    }
+
+    struct {
+      build_box box;
+      uint32_t count = 0;
+    } bins[sah_bins];
+    const double bin_scale = sah_bins / extent_size;
+    for (uint32_t i = begin; i < end; ++i) {
+      int b = static_cast<int>((centroids[indices[i]][axis] - extent_min) * bin_scale);
+      b = std::min(b, sah_bins - 1);
+      bins[b].count++;
+      bins[b].box.grow(primitive_boxes[indices[i]]);
+    }
+
+    // Sweep from the right to get the area and count on the far side of every plane.
+    double right_area[sah_bins - 1];
+    uint32_t right_count[sah_bins - 1];
+    build_box right_box;
+    uint32_t right_total = 0;
+    for (int b = sah_bins - 1; b > 0; --b) {
+      right_box.grow(bins[b].box);
+      right_total += bins[b].count;
+      right_area[b - 1] = right_box.surface_area();
+      right_count[b - 1] = right_total;
+    }
+
+    build_box left_box;
+    uint32_t left_total = 0;
+    for (int b = 0; b < sah_bins - 1; ++b) {
+      left_box.grow(bins[b].box);
+      left_total += bins[b].count;
+      if (left_total == 0 || right_count[b] == 0) {
+        continue;
+      }
+      double cost = traversal_cost + (left_total * left_box.surface_area() + right_count[b] * right_area[b]) / parent_area;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_split = b;
+      }
+    }
+  }
+
+  uint32_t mid;
+  int split_axis;
+  if (best_axis >= 0) {
+    // Splitting is only worth it if it beats intersecting every primitive here.
+    if (best_cost >= static_cast<double>(count) && count <= max_leaf_size_hard) {
+      return make_leaf();
+    }
+
+    const double extent_min = centroid_bounds.lo[best_axis];
+    const double bin_scale = sah_bins / (centroid_bounds.hi[best_axis] - centroid_bounds.lo[best_axis]);
+    auto it = std::partition(indices.begin() + begin, indices.begin() + end, [&](uint32_t index) {
+      int b = static_cast<int>((centroids[index][best_axis] - extent_min) * bin_scale);
+      return std::min(b, sah_bins - 1) <= best_split;
+    });
+    mid = static_cast<uint32_t>(it - indices.begin());
+    split_axis = best_axis;
+  } else {
+    // No usable SAH split: centroids coincide, or the tree is too deep for the
+    // traversal stack. Fall back to an object median split on the longest axis.
+    if (count <= max_leaf_size) {
+      return make_leaf();
+    }
+    split_axis = centroid_bounds.to_aabb().longest_axis();
+    mid = begin + count / 2;
+    std::nth_element(indices.begin() + begin, indices.begin() + mid, indices.begin() + end,
+                     [&](uint32_t a, uint32_t b) { return centroids[a][split_axis] < centroids[b][split_axis]; });
+  }
+
+  build_recursive(primitive_boxes, centroids, begin, mid, depth + 1);
+  uint32_t second_child = build_recursive(primitive_boxes, centroids, mid, end, depth + 1);
+
+  nodes[node_index].offset = second_child;
+  nodes[node_index].count = 0;
+  nodes[node_index].axis = static_cast<uint8_t>(split_axis);
+  return node_index;
+}
+
+// bvh method definitions
+bvh::bvh(const hittable_list& list): bvh(list.objects) {}
+
+bvh::bvh(std::vector<std::shared_ptr<hittable>> objects) {
+  std::vector<std::shared_ptr<hittable>> bounded;
+  std::vector<aabb> boxes;
+  for (auto& object : objects) {
+    aabb box = object->bounding_box();
+    if (box.is_bounded()) {
+      bounded.push_back(object);
+      boxes.push_back(box);
+    } else {
+      unbounded.add(object);
+    }
+  }
+
+  tree.build(boxes);
+
+  primitives.reserve(bounded.size());
+  for (uint32_t index : tree.indices) {
+    primitives.push_back(bounded[index]);
+  }
+
+  bbox = unbounded.objects.empty() ? tree.bounds() : aabb::universe;
+}
+
+bool bvh::intersect(const ray& r, interval ray_interval, intersection& isect) const {
+  bool hit_something = tree.traverse(r, ray_interval, [&](uint32_t slot, interval& current) {
+    if (primitives[slot]->intersect(r, current, isect)) {
+      current.max = isect.t;
+      return true;
+    }
+    return false;
+  });
+
+  real closest_position = hit_something ? isect.t : ray_interval.max;
+  if (!unbounded.objects.empty() && unbounded.intersect(r, interval(ray_interval.min, closest_position), isect)) {
+    hit_something = true;
+  }
+
+  return hit_something;
+}
+
+// Never the hit object itself; forwards in case a caller holds only the bvh.
+void bvh::surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const {
+  isect.object->surface_interaction(r, isect, rec);
+}
+
+uint32_t bvh::hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const {
+  uint32_t hits = tree.traverse_packet(packet, active, [&](uint32_t slot, uint32_t lanes) {
+    return primitives[slot]->hit_packet(packet, lanes, isects);
+  });
+
+  if (!unbounded.objects.empty()) {
+    hits |= unbounded.hit_packet(packet, active, isects);
+  }
+  return hits;
+}
+
+bool bvh::occluded(const ray& r, interval ray_interval) const {
+  if (tree.traverse_any(r, ray_interval, [&](uint32_t slot, const interval& current) {
+        return primitives[slot]->occluded(r, current);
+      })) {
+    return true;
+  }
+  return !unbounded.objects.empty() && unbounded.occluded(r, ray_interval);
+}
+
+aabb bvh::bounding_box() const {
+  return bbox;
+}
+
+size_t bvh::node_count() const {
+  return tree.nodes.size();
+}
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <fstream>
+#include <iostream>
 #include <thread>
 #include <vector>
 #include <atomic>
@@ -8,39 +9,85 @@
 #include <objects/camera.hpp>
 #include <objects/color.hpp>
 #include <objects/hittable.hpp>
+#include <objects/sampling.hpp>
 
-#include <materials/base.hpp>
+#include <materials/material_table.hpp>
 
 #include <constants.hpp>
+#include <io/image_writer.hpp>
+
+#include <render/accumulation_buffer.hpp>
+#include <render/denoiser.hpp>
+#include <render/tile_scheduler.hpp>
+#include <render/timeline.hpp>
+
 #include <progress.hpp>
 #include <randomizer.hpp>
 
 // camera method definitions
-void camera::render(const hittable& world) {
+void camera::render(const hittable& world, const material_table& scene_materials,
+                    const hittable_list* scene_lights) {
+  trace_span render_span("render", "render");
+  materials = &scene_materials;
+  lights = scene_lights != nullptr && !scene_lights->objects.empty() ? scene_lights : nullptr;
   initialize();
 
   const int total_pixels = image_width * image_height;
-  progress_bar progress(total_pixels);
+  const uint64_t camera_fingerprint = fingerprint();
 
-  // Framebuffer to store linear color (before gamma + byte conversion)
-  std::vector<color> framebuffer(total_pixels, color(0,0,0));
+  // Running per-pixel sums, optionally seeded from an earlier run's checkpoint
+  accumulation_buffer accum(image_width, image_height);
+  accum.seed = seed;
+  if(!checkpoint_path.empty() && accum.load(checkpoint_path, camera_fingerprint)) {
+    std::cout << "Resuming from " << checkpoint_path << " (" << accum.min_samples() << " spp done)" << std::endl;
+  }
+  // Pixels continue at their sample count, so this run draws sample numbers from
+  // the least-sampled pixel's count up to the most-sampled pixel's at save time.
+  const uint32_t first_sample = accum.min_samples();
+  auto save_buffer = [&](const std::string& path) {
+    accum.record_stream(sample_stream{seed, first_sample, accum.max_samples(), tile_size, tile_part, tile_part_count});
+    return accum.save(path, camera_fingerprint);
+  };
+
+  // Adaptive sampling needs several passes to re-check convergence; without an
+  // explicit pass size it tops pixels up adaptive_min_samples at a time. A
+  // checkpointed render needs passes too, or a killed run would have saved nothing.
+  const bool adaptive = adaptive_threshold > 0;
+  int default_pass = samples_per_pixel;
+  if(adaptive) {
+    default_pass = std::max(1, adaptive_min_samples);
+  } else if(!checkpoint_path.empty()) {
+    default_pass = std::max(1, std::min(samples_per_pixel, checkpoint_pass_samples));
+  }
+  const int pass_samples = samples_per_pass > 0 ? samples_per_pass : default_pass;
+  const int remaining = std::max(0, samples_per_pixel - static_cast<int>(accum.min_samples()));
+  // Upper bound: adaptive runs stop early once every pixel has converged.
+  const int pass_count = (remaining + pass_samples - 1) / pass_samples + (adaptive ? 1 : 0);
+
+  const int part_pixels = static_cast<int>(
+      tile_scheduler(image_width, image_height, tile_size, 1, tile_part, tile_part_count).pixel_count());
+  progress_bar progress(std::max(1, part_pixels * pass_count));
 
   // Multithreading setup
   const unsigned hw = std::thread::hardware_concurrency();
-  int thread_count = hw == 0 ? 4 : static_cast<int>(hw);
-  std::atomic<int> next_row{0};
+  const int workers = thread_count > 0 ? thread_count : (hw == 0 ? 4 : static_cast<int>(hw));
   std::atomic<int> pixels_done{0};
   std::atomic<bool> workers_finished{false};
 
   // Separate monitor thread to update progress safely (avoids data races in progress_bar)
   std::thread monitor([&](){
+    timeline::name_thread("monitor");
+    trace_span monitor_span("monitor", "render");
     int last_reported = 0;
     while(!workers_finished.load()) {
       int done = pixels_done.load();
       // Update progress for new completed pixels
-      while(last_reported < done) {
-        progress.update();
-        ++last_reported;
+      if(last_reported < done) {
+        trace_span update_span("progress", "render");
+        while(last_reported < done) {
+          progress.update();
+          ++last_reported;
+        }
       }
       std::this_thread::sleep_for(std::chrono::milliseconds(25));
     }
@@ -53,54 +100,138 @@ void camera::render(const hittable& world) {
     progress.finish();
   });
 
-  auto worker = [&](int /*id*/) {
-    while(true) {
-      int i = next_row.fetch_add(1);
-      if(i >= image_height) break;
-      for(int j=0; j<image_width; ++j) {
-        color pixel_color(0,0,0);
-        for(int sample=0; sample<samples_per_pixel; ++sample) {
-          ray r = get_ray(i, j);
-          pixel_color += get_ray_color(r, max_depth, world);
-        }
-        pixel_color *= pixel_samples_scale;
-        framebuffer[i * image_width + j] = pixel_color;
-        pixels_done.fetch_add(1, std::memory_order_relaxed);
+  stats.reset(workers);
+  auto last_checkpoint = std::chrono::steady_clock::now();
+  for(int pass=0; pass<pass_count; ++pass) {
+    trace_span pass_span("pass", "render", pass);
+    tile_scheduler scheduler(image_width, image_height, tile_size, workers, tile_part, tile_part_count);
+    std::atomic<long long> pass_sample_total{0};
+#ifdef RAYTRACING_STATS
+    std::vector<double> pass_busy(workers, 0.0);
+    const auto pass_start = std::chrono::steady_clock::now();
+#endif
+
+    auto worker = [&](int id) {
+      // Tiles accumulate into a thread-private buffer that is added into the shared
+      // accumulation buffer once, so threads never write to shared cache lines mid-tile.
+      accumulation_buffer local;
+      tile t;
+      timeline::name_thread("worker " + std::to_string(id));
+#ifdef RAYTRACING_STATS
+      render_stats::attach(&stats.worker(id));
+#endif
+      while(scheduler.next(id, t)) {
+        trace_span tile_span("tile", "render", t);
+#ifdef RAYTRACING_STATS
+        const auto tile_start = std::chrono::steady_clock::now();
+#endif
+        local.reset(t.width(), t.height());
+        render_tile(t, world, accum, pass_samples, local);
+        accum.merge_tile(t, local);
+        long long taken = 0;
+        for(uint32_t n : local.sample_count) taken += n;
+        pass_sample_total.fetch_add(taken, std::memory_order_relaxed);
+        pixels_done.fetch_add(t.pixel_count(), std::memory_order_relaxed);
+#ifdef RAYTRACING_STATS
+        pass_busy[id] += std::chrono::duration<double>(std::chrono::steady_clock::now() - tile_start).count();
+        stats.worker(id).tiles += 1;
+#endif
       }
+#ifdef RAYTRACING_STATS
+      render_stats::attach(nullptr);
+#endif
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for(int t=0; t<workers; ++t) {
+      threads.emplace_back(worker, t);
     }
-  };
+    for(auto& th : threads) {
+      th.join();
+    }
+#ifdef RAYTRACING_STATS
+    // Time a worker spent neither rendering nor merging counts as idle: waiting on
+    // the scheduler, or done early while others finish the pass.
+    const double pass_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pass_start).count();
+    for(int id=0; id<workers; ++id) {
+      stats.worker(id).busy_seconds += pass_busy[id];
+      stats.worker(id).idle_seconds += std::max(0.0, pass_seconds - pass_busy[id]);
+    }
+#endif
 
-  std::vector<std::thread> threads;
-  threads.reserve(thread_count);
-  for(int t=0; t<thread_count; ++t) {
-    threads.emplace_back(worker, t);
-  }
-  for(auto& th : threads) {
-    th.join();
+    // Every pixel has converged or reached samples_per_pixel
+    if(pass_sample_total.load() == 0) {
+      break;
+    }
+
+    // Checkpoint between passes, when no worker is touching the buffer
+    auto now = std::chrono::steady_clock::now();
+    if(!checkpoint_path.empty() && std::chrono::duration<double>(now - last_checkpoint).count() >= checkpoint_interval) {
+      trace_span checkpoint_span("checkpoint", "io");
+      save_buffer(checkpoint_path);
+      last_checkpoint = now;
+    }
   }
   workers_finished = true;
   monitor.join();
 
-  // Write PPM after rendering completes
-  std::ofstream file_out(file_path);
-  file_out << "P3\n";
-  file_out << image_width << " " << image_height << "\n" << 255 << "\n";
-  for(int i=0; i<image_height; ++i) {
-    for(int j=0; j<image_width; ++j) {
-      color c = get_color_byte(framebuffer[i * image_width + j]);
-      file_out << c.x() << " " << c.y() << " " << c.z() << "\n";
+  if(!checkpoint_path.empty()) {
+    trace_span checkpoint_span("checkpoint", "io");
+    save_buffer(checkpoint_path);
+  }
+  if(!sample_map_path.empty()) {
+    write_sample_map(accum);
+  }
+  if(render_stats::enabled()) {
+    stats.print(std::cout);
+    if(!stats_path.empty() && !stats.write_json(stats_path)) {
+      std::cerr << "Failed to write " << stats_path << std::endl;
     }
   }
+  if(!partial_path.empty()) {
+    if(!save_buffer(partial_path)) {
+      std::cerr << "Failed to write " << partial_path << std::endl;
+    }
+    return;
+  }
+
+  std::vector<color> framebuffer(total_pixels);
+  for(int index=0; index<total_pixels; ++index) {
+    framebuffer[index] = accum.resolve(index);
+  }
+  if(denoise || !aov_path.empty()) {
+    aov_buffer aovs;
+    render_aovs(world, workers, aovs);
+    if(!aov_path.empty()) {
+      write_aovs(aovs, workers);
+    }
+    if(denoise) {
+      std::vector<double> variance(total_pixels);
+      for(int index=0; index<total_pixels; ++index) {
+        variance[index] = accum.mean_variance(index);
+      }
+      denoiser pass = filter;
+      pass.thread_count = workers;
+      pass.apply(framebuffer, variance, aovs);
+    }
+  }
+
+  trace_span write_span("write image", "io");
+  if(!image_writer::for_path(file_path, workers)->write(file_path, image_width, image_height, framebuffer)) {
+    std::cerr << "Failed to write " << file_path << std::endl;
+  }
 }
 
 void camera::initialize() {
   image_height = std::max(1, static_cast<int>(image_width / aspect_ratio));
-  pixel_samples_scale = 1.0 / samples_per_pixel;
 
   // Vertical field-of-view in degrees to radians
   double theta = v_fov * PI / 180.0;
   double h = std::tan(theta / 2.0);
-  double viewport_height = 2.0 * h;
+  // A pinhole camera keeps the viewport at distance 1; a lens moves it to the focus plane.
+  double focus = defocus_angle > 0 ? focus_dist : 1.0;
+  double viewport_height = 2.0 * h * focus;
   double viewport_width = viewport_height * (static_cast<double>(image_width) / image_height);
 
   vec3 w = unit_vector(look_from - look_at);
@@ -110,41 +241,404 @@ void camera::initialize() {
   camera_position = look_from;
   vec3 horizontal = viewport_width * u;
   vec3 vertical = viewport_height * v;
-  upper_left_corner_pixel = camera_position - w - horizontal / 2 + vertical / 2;
+  upper_left_corner_pixel = camera_position - focus * w - horizontal / 2 + vertical / 2;
   pixel_delta_u = horizontal / image_width;
   pixel_delta_v = -vertical / image_height;
   upper_left_corner_pixel += 0.5 * (pixel_delta_u + pixel_delta_v);
+
+  double defocus_radius = focus * std::tan(defocus_angle / 2.0 * PI / 180.0);
+  defocus_disk_u = defocus_radius * u;
+  defocus_disk_v = defocus_radius * v;
+
+  pattern = sampler(sampling, samples_per_pixel, image_width);
 }
 
 ray camera::get_ray(int i, int j) const {
+  RT_STAT_INC(primary_rays);
   vec3 offset = sample_square();
   vec3 pixel_sample = upper_left_corner_pixel + ((offset.x() + j) * pixel_delta_u) + ((offset.y() + i) * pixel_delta_v);
 
-  vec3 ray_origin = camera_position;
+  vec3 ray_origin = defocus_angle > 0 ? defocus_disk_sample() : camera_position;
   vec3 ray_direction = pixel_sample - ray_origin;
 
   return ray(ray_origin, ray_direction);
 }
 
 vec3 camera::sample_square() const {
-  return vec3(random_double() - 0.5, random_double() - 0.5, 0);
+  double u[2];
+  thread_rng().fill(u, 2);
+  return vec3(u[0] - 0.5, u[1] - 0.5, 0);
+}
+
+point3 camera::defocus_disk_sample() const {
+  double u[2];
+  thread_rng().fill(u, 2);
+  vec3 p = sample_concentric_disk(u[0], u[1]).value;
+  return camera_position + p.x() * defocus_disk_u + p.y() * defocus_disk_v;
+}
+
+// Points the thread's random stream at sample number `sample` of pixel (i, j).
+// Sample numbers count from the first sample the pixel ever took, so passes and
+// resumed checkpoints keep drawing fresh, reproducible sequences.
+void camera::start_sample(int i, int j, uint32_t sample) const {
+  const sampler* source = sampling == sampler_kind::independent ? nullptr : &pattern;
+  thread_rng().start(seed, static_cast<uint64_t>(i) * image_width + j, sample, source);
+}
+
+// Adds up to pass_samples samples to every pixel of a tile that has not yet reached
+// samples_per_pixel. Sums and sample counts go to tile-sized, row-major buffers.
+void camera::render_tile(const tile& t, const hittable& world, const accumulation_buffer& accum, int pass_samples,
+                         accumulation_buffer& local) const {
+  if(use_wavefront) {
+    render_tile_wavefront(t, world, accum, pass_samples, local);
+    return;
+  }
+  if(use_ray_packets) {
+    for(int i=t.y0; i<t.y1; i+=ray_packet::block_width) {
+      for(int j=t.x0; j<t.x1; j+=ray_packet::block_width) {
+        render_packet_block(t, i, j, world, accum, pass_samples, local);
+      }
+    }
+    return;
+  }
+
+  for(int i=t.y0; i<t.y1; ++i) {
+    for(int j=t.x0; j<t.x1; ++j) {
+      int samples = pixel_pass_samples(accum, i, j, pass_samples);
+      int index = (i - t.y0) * t.width() + (j - t.x0);
+      uint32_t first_sample = accum.sample_count[i * image_width + j];
+      for(int sample=0; sample<samples; ++sample) {
+        start_sample(i, j, first_sample + sample);
+        ray r = get_ray(i, j);
+        local.add_sample(index, get_ray_color(r, world));
+      }
+    }
+  }
+}
+
+// Traces packets for the 4x4 pixel block whose upper-left pixel is (row, col).
+// Lanes outside the tile, or whose pixel already has enough samples, stay inactive.
+void camera::render_packet_block(const tile& t, int row, int col, const hittable& world, const accumulation_buffer& accum,
+                                 int pass_samples, accumulation_buffer& local) const {
+  int lane_samples[ray_packet::size] = {};
+  uint32_t lane_first_sample[ray_packet::size] = {};
+  intersection isects[ray_packet::size];
+
+  int block_samples = 0;
+  for(int lane=0; lane<ray_packet::size; ++lane) {
+    int i = row + lane / ray_packet::block_width;
+    int j = col + lane % ray_packet::block_width;
+    if(i < t.y1 && j < t.x1) {
+      lane_samples[lane] = pixel_pass_samples(accum, i, j, pass_samples);
+      lane_first_sample[lane] = accum.sample_count[i * image_width + j];
+      block_samples = std::max(block_samples, lane_samples[lane]);
+    }
+  }
+
+  for(int sample=0; sample<block_samples && max_depth>0; ++sample) {
+    ray_packet packet;
+    for(int lane=0; lane<ray_packet::size; ++lane) {
+      if(sample < lane_samples[lane]) {
+        int i = row + lane / ray_packet::block_width;
+        int j = col + lane % ray_packet::block_width;
+        start_sample(i, j, lane_first_sample[lane] + sample);
+        packet.set_lane(lane, get_ray(i, j), interval(0.001, INF));
+      }
+    }
+    packet.finalize();
+
+    uint32_t hits = world.hit_packet(packet, packet.valid, isects);
+
+    // Secondary bounces are incoherent, so shading continues one ray at a time.
+    for(int lane=0; lane<ray_packet::size; ++lane) {
+      uint32_t bit = 1u << lane;
+      if(!(packet.valid & bit)) continue;
+      ray r = packet.lane_ray(lane);
+      int i = row + lane / ray_packet::block_width;
+      int j = col + lane % ray_packet::block_width;
+      // Restart the lane's stream so shading draws the same numbers as the scalar path.
+      start_sample(i, j, lane_first_sample[lane] + sample);
+      color sample_color;
+      if(hits & bit) {
+        hit_record rec;
+        isects[lane].object->surface_interaction(r, isects[lane], rec);
+        sample_color = trace_from_hit(r, rec, world);
+      } else {
+        RT_STAT_END_PATH(paths_escaped, 1);
+        sample_color = background(r);
+      }
+      local.add_sample((i - t.y0) * t.width() + (j - t.x0), sample_color);
+    }
+  }
+}
+
+// Samples pixel (i, j) gets this pass. samples_per_pixel is the cap; with adaptive
+// sampling every pixel first reaches adaptive_min_samples and then stops as soon
+// as its noise estimate drops below adaptive_threshold.
+int camera::pixel_pass_samples(const accumulation_buffer& accum, int i, int j, int pass_samples) const {
+  const int index = i * image_width + j;
+  const int done = static_cast<int>(accum.sample_count[index]);
+  if(done >= samples_per_pixel) {
+    return 0;
+  }
+
+  int wanted = pass_samples;
+  if(adaptive_threshold > 0) {
+    if(done >= adaptive_min_samples && accum.noise_estimate(index) < adaptive_threshold) {
+      return 0;
+    }
+    wanted = std::max(wanted, adaptive_min_samples - done);
+  }
+  return std::min(wanted, samples_per_pixel - done);
+}
+
+// Writes the per-pixel sample counts as a grayscale PGM, white = samples_per_pixel.
+void camera::write_sample_map(const accumulation_buffer& accum) const {
+  std::ofstream file_out(sample_map_path);
+  file_out << "P2\n";
+  file_out << image_width << " " << image_height << "\n" << 255 << "\n";
+  for(int index=0; index<image_width * image_height; ++index) {
+    int value = static_cast<int>(255.0 * accum.sample_count[index] / std::max(1, samples_per_pixel));
+    file_out << std::min(255, value) << "\n";
+  }
+}
+
+// Traces aov_samples primary rays per pixel and averages what they hit first. The
+// rays are the ones the image's first samples started with, so AOV edges line up
+// with the rendered ones.
+void camera::render_aovs(const hittable& world, int workers, aov_buffer& aovs) const {
+  trace_span span("aovs", "render");
+  aovs.reset(image_width, image_height);
+  const int samples = std::max(1, aov_samples);
+  tile_scheduler scheduler(image_width, image_height, tile_size, workers);
+
+  auto worker = [&](int id) {
+    tile t;
+    while(scheduler.next(id, t)) {
+      for(int i=t.y0; i<t.y1; ++i) {
+        for(int j=t.x0; j<t.x1; ++j) {
+          color albedo(0, 0, 0);
+          vec3 normal(0, 0, 0);
+          double depth = 0;
+          for(int sample=0; sample<samples; ++sample) {
+            start_sample(i, j, sample);
+            ray r = get_ray(i, j);
+            hit_record rec;
+            if(world.hit(r, interval(0.001, INF), rec)) {
+              albedo += materials->albedo(rec.mat, rec);
+              normal += rec.normal;
+              depth += rec.t * r.direction().length();
+            } else {
+              albedo += background(r);
+            }
+          }
+          const int index = i * image_width + j;
+          aovs.albedo[index] = albedo / samples;
+          aovs.normal[index] = normal / samples;
+          aovs.depth[index] = depth / samples;
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(workers);
+  for(int t=0; t<workers; ++t) {
+    threads.emplace_back(worker, t);
+  }
+  for(auto& th : threads) {
+    th.join();
+  }
 }
 
-color camera::get_ray_color(const ray& r, int depth, const hittable& world) const {
-  if (depth <= 0) {
+void camera::write_aovs(const aov_buffer& aovs, int workers) const {
+  trace_span span("write aovs", "io");
+  std::vector<color> depth(aovs.depth.size());
+  for(size_t index=0; index<depth.size(); ++index) {
+    depth[index] = color(aovs.depth[index], aovs.depth[index], aovs.depth[index]);
+  }
+  const std::pair<std::string, const std::vector<color>*> outputs[] = {
+    {aov_path + ".albedo.pfm", &aovs.albedo},
+    {aov_path + ".normal.pfm", &aovs.normal},
+    {aov_path + ".depth.pfm", &depth},
+  };
+  for(const auto& output : outputs) {
+    if(!image_writer::for_path(output.first, workers)->write(output.first, image_width, image_height, *output.second)) {
+      std::cerr << "Failed to write " << output.first << std::endl;
+    }
+  }
+}
+
+// Identifies everything about the camera that changes what a pixel converges to,
+// so checkpoints are only resumed by an identical setup (FNV-1a over the fields).
+uint64_t camera::fingerprint() const {
+  uint64_t hash = 1469598103934665603ull;
+  auto mix = [&hash](const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t k=0; k<size; ++k) {
+      hash ^= bytes[k];
+      hash *= 1099511628211ull;
+    }
+  };
+  // The seed is stored next to the fingerprint instead, since parts rendered with
+  // different seeds are meant to be merged. The integrator is left out: recursive
+  // and wavefront rendering produce the same samples.
+  mix(&scene_fingerprint, sizeof(scene_fingerprint));
+  mix(&image_width, sizeof(image_width));
+  mix(&image_height, sizeof(image_height));
+  mix(&max_depth, sizeof(max_depth));
+  mix(&roulette_depth, sizeof(roulette_depth));
+  mix(&sampling, sizeof(sampling));
+  mix(&v_fov, sizeof(v_fov));
+  for(const vec3* v : {&look_from, &look_at, &v_up}) {
+    // As doubles, so float and double builds agree on the fingerprint
+    for(int axis=0; axis<3; ++axis) {
+      double component = (*v)[axis];
+      mix(&component, sizeof(component));
+    }
+  }
+  if(!use_sky) {
+    for(int axis=0; axis<3; ++axis) {
+      double component = background_color[axis];
+      mix(&component, sizeof(component));
+    }
+  }
+  if(defocus_angle > 0) {
+    mix(&defocus_angle, sizeof(defocus_angle));
+    mix(&focus_dist, sizeof(focus_dist));
+  }
+  return hash;
+}
+
+color camera::get_ray_color(const ray& r, const hittable& world) const {
+  if (max_depth <= 0) {
     return color(0,0,0);
   }
 
   hit_record rec;
   if (world.hit(r, interval(0.001, INF), rec)) {
+    return trace_from_hit(r, rec, world);
+  }
+
+  RT_STAT_END_PATH(paths_escaped, 1);
+  return background(r);
+}
+
+// Follows a path from its first hit, carrying the product of attenuations so far,
+// until it escapes to the sky, is absorbed, reaches max_depth or loses at roulette.
+// Light reaches the path two ways: by hitting an emitter, and at every diffuse
+// vertex through a shadow ray to a sampled light (next-event estimation). Where
+// both can find the same light, multiple importance sampling weights each so
+// they add up to one estimate.
+color camera::trace_from_hit(ray r, hit_record rec, const hittable& world) const {
+  color throughput(1, 1, 1);
+  color radiance(0, 0, 0);
+  // Density of the BSDF sample that led to rec; 0 for camera rays and specular
+  // bounces, whose emitter hits light sampling could not have found.
+  double scatter_pdf = 0;
+  for (int bounce = 1; ; ++bounce) {
+    const color emitted = materials->emitted(rec.mat, rec);
+    if (emitted.x() > 0 || emitted.y() > 0 || emitted.z() > 0) {
+      radiance += throughput * emitted * emission_weight(r, scatter_pdf);
+    }
+
+    thread_rng().set_bounce(static_cast<uint32_t>(bounce));
     ray scattered;
     color attenuation;
-    if (rec.mat && rec.mat->scatter(r, rec, attenuation, scattered)) {
-      return attenuation * get_ray_color(scattered, depth - 1, world);
+    const bool scatters = materials->scatter(rec.mat, r, rec, attenuation, scattered);
+    if (!scatters || bounce >= max_depth) {
+      if (!scatters) {
+        RT_STAT_END_PATH(paths_absorbed, bounce);
+      } else {
+        RT_STAT_END_PATH(paths_max_depth, bounce);
+      }
+      return radiance;
+    }
+    if (lights != nullptr) {
+      scatter_pdf = materials->scattering_pdf(rec.mat, r, rec, scattered.direction());
+      if (scatter_pdf > 0) {
+        radiance += throughput * sample_lights(r, rec, world);
+      }
+    }
+    throughput = throughput * attenuation;
+    if (!survives_roulette(bounce, throughput)) {
+      RT_STAT_END_PATH(paths_roulette, bounce);
+      return radiance;
+    }
+
+    r = scattered;
+    RT_STAT_INC(secondary_rays);
+    if (!world.hit(r, interval(0.001, INF), rec)) {
+      RT_STAT_END_PATH(paths_escaped, bounce + 1);
+      return radiance + throughput * background(r);
     }
-    return color(0,0,0);
   }
+}
 
+// Next-event estimation at a diffuse vertex: one shadow ray toward a point of a
+// randomly chosen light. The nearest light along the ray (found in the short
+// light list) contributes if an any-hit query finds nothing in front of it.
+color camera::sample_lights(const ray& r_in, const hit_record& rec, const hittable& world) const {
+  const vec3 direction = lights->random_direction(rec.p);
+  const double light_pdf = lights->pdf_value(rec.p, direction);
+  if (light_pdf <= 0) {
+    return color(0, 0, 0);
+  }
+  const color f = materials->evaluate(rec.mat, r_in, rec, direction);
+  if (f.x() <= 0 && f.y() <= 0 && f.z() <= 0) {
+    return color(0, 0, 0);
+  }
+
+  const ray shadow(rec.p, direction);
+  hit_record light_rec;
+  if (!lights->hit(shadow, interval(0.001, INF), light_rec)) {
+    return color(0, 0, 0);
+  }
+  const color emitted = materials->emitted(light_rec.mat, light_rec);
+  if (emitted.x() <= 0 && emitted.y() <= 0 && emitted.z() <= 0) {
+    return color(0, 0, 0);
+  }
+  // Stop just short of the light so its own surface does not count as a blocker.
+  RT_STAT_INC(shadow_rays);
+  if (world.occluded(shadow, interval(0.001, light_rec.t * (1 - 1e-6)))) {
+    return color(0, 0, 0);
+  }
+
+  const double bsdf_pdf = materials->scattering_pdf(rec.mat, r_in, rec, direction);
+  const double weight = light_pdf * light_pdf / (light_pdf * light_pdf + bsdf_pdf * bsdf_pdf);
+  return f * emitted * (weight / light_pdf);
+}
+
+// Power heuristic weight of an emitter that the BSDF sample r found, against the
+// chance that light sampling from r's origin would have picked the same direction.
+double camera::emission_weight(const ray& r, double scatter_pdf) const {
+  if (lights == nullptr || scatter_pdf <= 0) {
+    return 1.0;
+  }
+  const double light_pdf = lights->pdf_value(r.origin(), r.direction());
+  return scatter_pdf * scatter_pdf / (scatter_pdf * scatter_pdf + light_pdf * light_pdf);
+}
+
+// Russian roulette: past roulette_depth bounces a path continues with probability
+// equal to its largest throughput component (at most 1), and survivors are
+// reweighted by 1/p so the estimate stays unbiased.
+bool camera::survives_roulette(int bounce, color& throughput) const {
+  if (roulette_depth <= 0 || bounce < roulette_depth) {
+    return true;
+  }
+  real p = std::min(real(1), std::max(throughput.x(), std::max(throughput.y(), throughput.z())));
+  if (p <= 0 || random_double() >= p) {
+    return false;
+  }
+  throughput /= p;
+  return true;
+}
+
+// Sky gradient seen by rays that escape the scene
+color camera::background(const ray& r) const {
+  if (!use_sky) {
+    return background_color;
+  }
   vec3 unit_direction = unit_vector(r.direction());
   double t = 0.5 * (unit_direction.y() + 1.0);
   return (1.0 - t) * color(1.0, 1.0, 1.0) + t * color(0.5, 0.7, 1.0);
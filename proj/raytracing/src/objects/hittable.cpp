@@ -1,8 +1,46 @@
+#include <algorithm>
 #include <memory>
 
 #include <objects/hittable.hpp>
 #include <objects/hit_record.hpp>
 
+#include <randomizer.hpp>
+
+// hittable method definitions
+uint32_t hittable::hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const {
+  uint32_t hits = 0;
+  for (int lane = 0; lane < ray_packet::size; ++lane) {
+    if (!(active & (1u << lane))) continue;
+    if (intersect(packet.lane_ray(lane), interval(packet.t_min, packet.t_max[lane]), isects[lane])) {
+      packet.t_max[lane] = isects[lane].t;
+      hits |= 1u << lane;
+    }
+  }
+  return hits;
+}
+
+bool hittable::hit(const ray& r, interval ray_interval, hit_record& rec) const {
+  intersection isect;
+  if (!intersect(r, ray_interval, isect)) {
+    return false;
+  }
+  isect.object->surface_interaction(r, isect, rec);
+  return true;
+}
+
+bool hittable::occluded(const ray& r, interval ray_interval) const {
+  intersection isect;
+  return intersect(r, ray_interval, isect);
+}
+
+vec3 hittable::random_direction(const point3&) const {
+  return vec3(1, 0, 0);
+}
+
+double hittable::pdf_value(const point3&, const vec3&) const {
+  return 0.0;
+}
+
 // hittable_list method definitions
 hittable_list::hittable_list(std::shared_ptr<hittable> object) {
   add(object);
@@ -10,24 +48,68 @@ hittable_list::hittable_list(std::shared_ptr<hittable> object) {
 
 void hittable_list::clear() {
   objects.clear();
+  bbox = aabb();
 }
 
 void hittable_list::add(std::shared_ptr<hittable> object) {
   objects.emplace_back(object);
+  bbox = aabb(bbox, object->bounding_box());
 }
 
-bool hittable_list::hit(const ray& r, interval ray_interval, hit_record& rec) const {
-  hit_record temp_record;
+bool hittable_list::intersect(const ray& r, interval ray_interval, intersection& isect) const {
   bool hit_something = false;
-  double closest_position = ray_interval.max;
+  real closest_position = ray_interval.max;
 
   for (const auto& object : objects) {
-    if (object->hit(r, interval(ray_interval.min, closest_position), temp_record)) {
+    if (object->intersect(r, interval(ray_interval.min, closest_position), isect)) {
       hit_something = true;
-      closest_position = temp_record.t;
-      rec = temp_record;
+      closest_position = isect.t;
     }
   }
 
   return hit_something;
-}
\ No newline at end of file
+}
+
+// Never the hit object itself; forwards in case a caller holds only the list.
+void hittable_list::surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const {
+  isect.object->surface_interaction(r, isect, rec);
+}
+
+aabb hittable_list::bounding_box() const {
+  return bbox;
+}
+
+uint32_t hittable_list::hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const {
+  uint32_t hits = 0;
+  for (const auto& object : objects) {
+    hits |= object->hit_packet(packet, active, isects);
+  }
+  return hits;
+}
+bool hittable_list::occluded(const ray& r, interval ray_interval) const {
+  for (const auto& object : objects) {
+    if (object->occluded(r, ray_interval)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+vec3 hittable_list::random_direction(const point3& origin) const {
+  if (objects.empty()) {
+    return vec3(1, 0, 0);
+  }
+  const size_t pick = std::min(objects.size() - 1, static_cast<size_t>(random_double() * objects.size()));
+  return objects[pick]->random_direction(origin);
+}
+
+double hittable_list::pdf_value(const point3& origin, const vec3& direction) const {
+  if (objects.empty()) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for (const auto& object : objects) {
+    sum += object->pdf_value(origin, direction);
+  }
+  return sum / objects.size();
+}
@@ -0,0 +1,80 @@
+#include <objects/instance.hpp>
+
+#include <render/render_stats.hpp>
+
+// instance method definitions
+std::shared_ptr<instance> instance::create(std::shared_ptr<hittable> object, const affine_transform& object_to_world,
+                                           material_id mat) {
+  std::shared_ptr<instance> result(new instance());
+  if (!object || !object_to_world.invert(result->world_to_object)) {
+    return nullptr;
+  }
+  result->object = std::move(object);
+  result->object_to_world = object_to_world;
+  result->mat = mat;
+  result->bbox = object_to_world.apply_box(result->object->bounding_box());
+  return result;
+}
+
+bool instance::intersect(const ray& r, interval ray_interval, intersection& isect) const {
+  RT_STAT_INC(instance_tests);
+  intersection local;
+  if (!object->intersect(world_to_object.apply_ray(r), ray_interval, local)) {
+    return false;
+  }
+
+  isect.t = local.t;
+  isect.object = this;
+  isect.child = local.object;
+  isect.primitive = local.primitive;
+  return true;
+}
+
+bool instance::occluded(const ray& r, interval ray_interval) const {
+  RT_STAT_INC(instance_tests);
+  return object->occluded(world_to_object.apply_ray(r), ray_interval);
+}
+
+void instance::surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const {
+  const ray local_ray = world_to_object.apply_ray(r);
+  intersection local;
+  local.t = isect.t;
+  local.object = isect.child;
+  local.primitive = isect.primitive;
+  isect.child->surface_interaction(local_ray, local, rec);
+
+  // The shape faced its normal against the object-space ray; recover the outward
+  // normal and face it again against the world ray.
+  const vec3 outward = rec.front_face ? rec.normal : -rec.normal;
+  rec.p = r.at(rec.t);
+  rec.set_face_normal(r, unit_vector(world_to_object.apply_transposed(outward)));
+  if (mat != no_material) {
+    rec.mat = mat;
+  }
+}
+
+aabb instance::bounding_box() const {
+  return bbox;
+}
+
+uint32_t instance::hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const {
+  // Trace an object-space copy of the packet; t values carry over unchanged.
+  ray_packet local;
+  for (int lane = 0; lane < ray_packet::size; ++lane) {
+    if (!(packet.valid & (1u << lane))) continue;
+    local.set_lane(lane, world_to_object.apply_ray(packet.lane_ray(lane)), interval(packet.t_min, packet.t_max[lane]));
+  }
+  local.finalize();
+
+  intersection local_isects[ray_packet::size];
+  uint32_t hits = object->hit_packet(local, active, local_isects);
+  for (int lane = 0; lane < ray_packet::size; ++lane) {
+    if (!(hits & (1u << lane))) continue;
+    packet.t_max[lane] = local.t_max[lane];
+    isects[lane].t = local_isects[lane].t;
+    isects[lane].object = this;
+    isects[lane].child = local_isects[lane].object;
+    isects[lane].primitive = local_isects[lane].primitive;
+  }
+  return hits;
+}
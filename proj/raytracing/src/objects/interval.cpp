@@ -1,19 +1,24 @@
 #include <objects/interval.hpp>
 
 // interval method definitions
-double interval::size() const {
+interval::interval(const interval& a, const interval& b) {
+  min = a.min <= b.min ? a.min : b.min;
+  max = a.max >= b.max ? a.max : b.max;
+}
+
+real interval::size() const {
   return max - min;
 }
 
-bool interval::contains(double x) const {
+bool interval::contains(real x) const {
   return min <= x && x <= max;
 }
 
-bool interval::surrounds(double x) const {
+bool interval::surrounds(real x) const {
   return min < x && x < max;
 }
 
-double interval::clamp(double x) const {
+real interval::clamp(real x) const {
   if (x < min) {
     return min;
   }
@@ -23,5 +28,10 @@ double interval::clamp(double x) const {
   return x;
 }
 
+interval interval::expand(real delta) const {
+  real padding = delta / 2;
+  return interval(min - padding, max + padding);
+}
+
 const interval interval::empty = interval(INF, -INF);
 const interval interval::universe = interval(-INF, INF);
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cmath>
+
+#include <objects/ray_packet.hpp>
+
+// ray_packet method definitions
+void ray_packet::set_lane(int lane, const ray& r, interval ray_interval) {
+  const point3& o = r.origin();
+  const vec3& d = r.direction();
+  origin_x[lane] = o.x();
+  origin_y[lane] = o.y();
+  origin_z[lane] = o.z();
+  direction_x[lane] = d.x();
+  direction_y[lane] = d.y();
+  direction_z[lane] = d.z();
+  inv_direction_x[lane] = 1 / d.x();
+  inv_direction_y[lane] = 1 / d.y();
+  inv_direction_z[lane] = 1 / d.z();
+  t_min = ray_interval.min;
+  t_max[lane] = ray_interval.max;
+  valid |= 1u << lane;
+}
+
+ray ray_packet::lane_ray(int lane) const {
+  return ray(point3(origin_x[lane], origin_y[lane], origin_z[lane]),
+             vec3(direction_x[lane], direction_y[lane], direction_z[lane]));
+}
+
+void ray_packet::finalize() {
+  const real* origins[3] = {origin_x, origin_y, origin_z};
+  const real* inv_directions[3] = {inv_direction_x, inv_direction_y, inv_direction_z};
+
+  for (int axis = 0; axis < 3; ++axis) {
+    origin_bounds[axis] = interval();
+    inv_direction_bounds[axis] = interval();
+    for (int lane = 0; lane < size; ++lane) {
+      if (!(valid & (1u << lane))) continue;
+      real o = origins[axis][lane];
+      real inv = inv_directions[axis][lane];
+      origin_bounds[axis] = interval(std::min(origin_bounds[axis].min, o), std::max(origin_bounds[axis].max, o));
+      inv_direction_bounds[axis] = interval(std::min(inv_direction_bounds[axis].min, inv), std::max(inv_direction_bounds[axis].max, inv));
+    }
+    const interval& inv = inv_direction_bounds[axis];
+    has_frustum[axis] = std::isfinite(inv.min) && std::isfinite(inv.max) && (inv.min > 0 || inv.max < 0);
+  }
+}
+
+bool ray_packet::frustum_misses(const aabb& box, uint32_t active) const {
+  real packet_t_max = -INF;
+  for (int lane = 0; lane < size; ++lane) {
+    if ((active & (1u << lane)) && t_max[lane] > packet_t_max) {
+      packet_t_max = t_max[lane];
+    }
+  }
+
+  // Lower bound of every lane's entry distance and upper bound of its exit distance
+  real enter_lower = t_min;
+  real exit_upper = packet_t_max;
+
+  for (int axis = 0; axis < 3; ++axis) {
+    if (!has_frustum[axis]) continue;
+
+    const interval& slab = box.axis_interval(axis);
+    const interval& o = origin_bounds[axis];
+    const interval& inv = inv_direction_bounds[axis];
+    bool negative = inv.max < 0;
+
+    // Interval of (near_face - origin) and (far_face - origin) over all lanes
+    real near_face = negative ? slab.max : slab.min;
+    real far_face = negative ? slab.min : slab.max;
+    interval near_offset(near_face - o.max, near_face - o.min);
+    interval far_offset(far_face - o.max, far_face - o.min);
+
+    // Interval products: bounds are attained at the corners.
+    real near_products[4] = {near_offset.min * inv.min, near_offset.min * inv.max,
+                               near_offset.max * inv.min, near_offset.max * inv.max};
+    real far_products[4] = {far_offset.min * inv.min, far_offset.min * inv.max,
+                              far_offset.max * inv.min, far_offset.max * inv.max};
+
+    enter_lower = std::max(enter_lower, *std::min_element(near_products, near_products + 4));
+    exit_upper = std::min(exit_upper, *std::max_element(far_products, far_products + 4));
+
+    if (enter_lower > exit_upper) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t ray_packet::hit_lanes(const aabb& box, uint32_t active) const {
+  uint32_t result = 0;
+  for (int lane = 0; lane < size; ++lane) {
+    if (!(active & (1u << lane))) continue;
+
+    real t_enter = t_min;
+    real t_exit = t_max[lane];
+    const real origin[3] = {origin_x[lane], origin_y[lane], origin_z[lane]};
+    const real inv_dir[3] = {inv_direction_x[lane], inv_direction_y[lane], inv_direction_z[lane]};
+    for (int axis = 0; axis < 3; ++axis) {
+      const interval& slab = box.axis_interval(axis);
+      real t0 = (slab.min - origin[axis]) * inv_dir[axis];
+      real t1 = (slab.max - origin[axis]) * inv_dir[axis];
+      if (t0 > t1) std::swap(t0, t1);
+      // NaN (ray lying on a slab plane) fails both comparisons and is ignored.
+      if (t0 > t_enter) t_enter = t0;
+      if (t1 < t_exit) t_exit = t1;
+    }
+    if (t_enter <= t_exit) {
+      result |= 1u << lane;
+    }
+  }
+  return result;
+}
+
+bool ray_packet::direction_negative(int axis, uint32_t active) const {
+  const real* inv_directions[3] = {inv_direction_x, inv_direction_y, inv_direction_z};
+  int lane = 0;
+  while (lane < size - 1 && !(active & (1u << lane))) ++lane;
+  return inv_directions[axis][lane] < 0;
+}
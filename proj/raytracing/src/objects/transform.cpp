@@ -0,0 +1,102 @@
+#include <cmath>
+
+#include <objects/transform.hpp>
+
+#include <constants.hpp>
+
+// affine_transform method definitions
+affine_transform affine_transform::translation(const vec3& offset) {
+  affine_transform t;
+  for (int row = 0; row < 3; ++row) {
+    t.m[row][3] = offset[row];
+  }
+  return t;
+}
+
+affine_transform affine_transform::scaling(const vec3& factors) {
+  affine_transform t;
+  for (int row = 0; row < 3; ++row) {
+    t.m[row][row] = factors[row];
+  }
+  return t;
+}
+
+affine_transform affine_transform::rotation(const vec3& axis, double degrees) {
+  // Rodrigues' formula: R = cos I + sin [a]x + (1 - cos) a a^T
+  const vec3 a = unit_vector(axis);
+  const double radians = degrees * PI / 180.0;
+  const double c = std::cos(radians);
+  const double s = std::sin(radians);
+  const double k = 1.0 - c;
+
+  affine_transform t;
+  t.m[0][0] = c + k * a[0] * a[0];
+  t.m[0][1] = k * a[0] * a[1] - s * a[2];
+  t.m[0][2] = k * a[0] * a[2] + s * a[1];
+  t.m[1][0] = k * a[1] * a[0] + s * a[2];
+  t.m[1][1] = c + k * a[1] * a[1];
+  t.m[1][2] = k * a[1] * a[2] - s * a[0];
+  t.m[2][0] = k * a[2] * a[0] - s * a[1];
+  t.m[2][1] = k * a[2] * a[1] + s * a[0];
+  t.m[2][2] = c + k * a[2] * a[2];
+  return t;
+}
+
+affine_transform operator*(const affine_transform& a, const affine_transform& b) {
+  affine_transform t;
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      double value = col == 3 ? a.m[row][3] : 0.0;
+      for (int k = 0; k < 3; ++k) {
+        value += a.m[row][k] * b.m[k][col];
+      }
+      t.m[row][col] = value;
+    }
+  }
+  return t;
+}
+
+aabb affine_transform::apply_box(const aabb& box) const {
+  if (!box.is_bounded()) {
+    return aabb::universe;
+  }
+
+  aabb result;
+  for (int corner = 0; corner < 8; ++corner) {
+    const point3 p((corner & 1) ? box.x.max : box.x.min,
+                   (corner & 2) ? box.y.max : box.y.min,
+                   (corner & 4) ? box.z.max : box.z.min);
+    const point3 q = apply_point(p);
+    result = aabb(result, aabb(q, q));
+  }
+  return result;
+}
+
+bool affine_transform::invert(affine_transform& inverse) const {
+  // Adjugate of A over its determinant, then b' = -A^-1 b
+  const double c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+  const double c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+  const double c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+  const double determinant = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+  if (determinant == 0 || !std::isfinite(determinant)) {
+    return false;
+  }
+
+  const double inv_det = 1.0 / determinant;
+  affine_transform t;
+  t.m[0][0] = c00 * inv_det;
+  t.m[1][0] = c01 * inv_det;
+  t.m[2][0] = c02 * inv_det;
+  t.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+  t.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+  t.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+  t.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+  t.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+  t.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+  for (int row = 0; row < 3; ++row) {
+    t.m[row][3] = -(t.m[row][0] * m[0][3] + t.m[row][1] * m[1][3] + t.m[row][2] * m[2][3]);
+  }
+
+  inverse = t;
+  return true;
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <render/accumulation_buffer.hpp>
+
+#include <constants.hpp>
+
+namespace {
+
+const char checkpoint_magic[4] = {'R', 'T', 'C', 'K'};
+const uint32_t checkpoint_version = 4;
+
+// On-disk layout of a sample_stream
+struct stream_record {
+  uint64_t seed;
+  uint32_t first_sample;
+  uint32_t end_sample;
+  int32_t tile_size;
+  int32_t tile_part;
+  int32_t tile_part_count;
+  uint32_t padding;
+};
+static_assert(sizeof(stream_record) == 32, "stream_record must match the checkpoint layout");
+
+// Upper bound on the stream count of a checkpoint, to reject corrupt headers
+const uint32_t max_streams = 1u << 20;
+
+int gcd(int a, int b) {
+  while (b != 0) {
+    int r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+}
+
+// sample_stream method definitions
+bool sample_stream::overlaps(const sample_stream& other) const {
+  if (seed != other.seed || end_sample <= other.first_sample || other.end_sample <= first_sample) {
+    return false;
+  }
+  if (tile_size != other.tile_size) {
+    return true;
+  }
+  // Part p of N keeps tiles p, p + N, ...; parts p of N and q of M share a tile
+  // exactly when p and q agree modulo gcd(N, M).
+  const int step = gcd(std::max(1, tile_part_count), std::max(1, other.tile_part_count));
+  return (tile_part - other.tile_part) % step == 0;
+}
+
+// accumulation_buffer method definitions
+accumulation_buffer::accumulation_buffer(int _width, int _height)
+  : width(_width), height(_height),
+    sum(static_cast<size_t>(_width) * _height, basic_vec3<double>(0, 0, 0)),
+    luminance_sq_sum(static_cast<size_t>(_width) * _height, 0.0),
+    sample_count(static_cast<size_t>(_width) * _height, 0) {}
+
+void accumulation_buffer::reset(int _width, int _height) {
+  width = _width;
+  height = _height;
+  size_t n = static_cast<size_t>(width) * height;
+  sum.assign(n, basic_vec3<double>(0, 0, 0));
+  luminance_sq_sum.assign(n, 0.0);
+  sample_count.assign(n, 0);
+}
+
+void accumulation_buffer::add_sample(int index, const color& sample) {
+  const basic_vec3<double> value(sample);
+  double l = luminance(value);
+  sum[index] += value;
+  luminance_sq_sum[index] += l * l;
+  sample_count[index] += 1;
+}
+
+void accumulation_buffer::merge_tile(const tile& t, const accumulation_buffer& local) {
+  for (int i = t.y0; i < t.y1; ++i) {
+    for (int j = t.x0; j < t.x1; ++j) {
+      int src = (i - t.y0) * local.width + (j - t.x0);
+      int dst = i * width + j;
+      sum[dst] += local.sum[src];
+      luminance_sq_sum[dst] += local.luminance_sq_sum[src];
+      sample_count[dst] += local.sample_count[src];
+    }
+  }
+}
+
+void accumulation_buffer::merge(const accumulation_buffer& other) {
+  merge_tile(tile{0, 0, width, height}, other);
+  streams.insert(streams.end(), other.streams.begin(), other.streams.end());
+}
+
+void accumulation_buffer::record_stream(const sample_stream& run) {
+  for (sample_stream& s : streams) {
+    if (s.seed == run.seed && s.tile_size == run.tile_size && s.tile_part == run.tile_part &&
+        s.tile_part_count == run.tile_part_count && s.end_sample >= run.first_sample &&
+        run.end_sample >= s.first_sample) {
+      s.first_sample = std::min(s.first_sample, run.first_sample);
+      s.end_sample = std::max(s.end_sample, run.end_sample);
+      return;
+    }
+  }
+  streams.push_back(run);
+}
+
+color accumulation_buffer::resolve(int index) const {
+  uint32_t n = sample_count[index];
+  if (n == 0) {
+    return color(0, 0, 0);
+  }
+  return color(sum[index] / static_cast<double>(n));
+}
+
+uint32_t accumulation_buffer::min_samples() const {
+  if (sample_count.empty()) {
+    return 0;
+  }
+  return *std::min_element(sample_count.begin(), sample_count.end());
+}
+
+uint32_t accumulation_buffer::max_samples() const {
+  if (sample_count.empty()) {
+    return 0;
+  }
+  return *std::max_element(sample_count.begin(), sample_count.end());
+}
+
+double accumulation_buffer::noise_estimate(int index) const {
+  uint32_t n = sample_count[index];
+  if (n < 2) {
+    return INF;
+  }
+
+  double mean = luminance(sum[index]) / n;
+  double half_width = 1.96 * std::sqrt(mean_variance(index));
+
+  // Display values are sqrt(linear) (gamma 2). Propagate the interval through the
+  // derivative 1 / (2 sqrt(mean)), bounded by sqrt(half_width) for dark pixels.
+  double display_half_width = std::sqrt(half_width);
+  if (mean > 0) {
+    display_half_width = std::min(display_half_width, half_width / (2.0 * std::sqrt(mean)));
+  }
+  return display_half_width;
+}
+
+double accumulation_buffer::mean_variance(int index) const {
+  uint32_t n = sample_count[index];
+  if (n < 2) {
+    return INF;
+  }
+
+  double mean = luminance(sum[index]) / n;
+  double variance = std::max(0.0, (luminance_sq_sum[index] - n * mean * mean) / (n - 1));
+  return variance / n;
+}
+
+bool accumulation_buffer::save(const std::string& path, uint64_t fingerprint) const {
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    out.write(checkpoint_magic, sizeof(checkpoint_magic));
+    out.write(reinterpret_cast<const char*>(&checkpoint_version), sizeof(checkpoint_version));
+    out.write(reinterpret_cast<const char*>(&width), sizeof(width));
+    out.write(reinterpret_cast<const char*>(&height), sizeof(height));
+    out.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+    out.write(reinterpret_cast<const char*>(&seed), sizeof(seed));
+    const uint32_t stream_count = static_cast<uint32_t>(streams.size());
+    out.write(reinterpret_cast<const char*>(&stream_count), sizeof(stream_count));
+    for (const sample_stream& s : streams) {
+      const stream_record record{s.seed, s.first_sample, s.end_sample, s.tile_size, s.tile_part, s.tile_part_count, 0};
+      out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    out.write(reinterpret_cast<const char*>(sum.data()), sum.size() * sizeof(basic_vec3<double>));
+    out.write(reinterpret_cast<const char*>(luminance_sq_sum.data()), luminance_sq_sum.size() * sizeof(double));
+    out.write(reinterpret_cast<const char*>(sample_count.data()), sample_count.size() * sizeof(uint32_t));
+    if (!out) {
+      return false;
+    }
+  }
+  return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+bool accumulation_buffer::load(const std::string& path, uint64_t fingerprint) {
+  accumulation_buffer file;
+  uint64_t file_fingerprint = 0;
+  if (!file.read(path, file_fingerprint) || file.width != width || file.height != height ||
+      file_fingerprint != fingerprint || file.seed != seed) {
+    return false;
+  }
+
+  sum.swap(file.sum);
+  luminance_sq_sum.swap(file.luminance_sq_sum);
+  sample_count.swap(file.sample_count);
+  streams.swap(file.streams);
+  return true;
+}
+
+bool accumulation_buffer::read(const std::string& path, uint64_t& fingerprint) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+
+  char magic[4];
+  uint32_t version = 0;
+  int file_width = 0;
+  int file_height = 0;
+  uint64_t file_fingerprint = 0;
+  uint64_t file_seed = 0;
+  uint32_t stream_count = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&file_width), sizeof(file_width));
+  in.read(reinterpret_cast<char*>(&file_height), sizeof(file_height));
+  in.read(reinterpret_cast<char*>(&file_fingerprint), sizeof(file_fingerprint));
+  in.read(reinterpret_cast<char*>(&file_seed), sizeof(file_seed));
+  in.read(reinterpret_cast<char*>(&stream_count), sizeof(stream_count));
+  if (!in || std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0 || version != checkpoint_version ||
+      file_width <= 0 || file_height <= 0 || stream_count > max_streams) {
+    return false;
+  }
+
+  std::vector<sample_stream> file_streams(stream_count);
+  for (sample_stream& s : file_streams) {
+    stream_record record;
+    in.read(reinterpret_cast<char*>(&record), sizeof(record));
+    s.seed = record.seed;
+    s.first_sample = record.first_sample;
+    s.end_sample = record.end_sample;
+    s.tile_size = record.tile_size;
+    s.tile_part = record.tile_part;
+    s.tile_part_count = record.tile_part_count;
+  }
+
+  const size_t n = static_cast<size_t>(file_width) * file_height;
+  std::vector<basic_vec3<double>> file_sum(n);
+  std::vector<double> file_sq_sum(n);
+  std::vector<uint32_t> file_count(n);
+  in.read(reinterpret_cast<char*>(file_sum.data()), file_sum.size() * sizeof(basic_vec3<double>));
+  in.read(reinterpret_cast<char*>(file_sq_sum.data()), file_sq_sum.size() * sizeof(double));
+  in.read(reinterpret_cast<char*>(file_count.data()), file_count.size() * sizeof(uint32_t));
+  if (!in) {
+    return false;
+  }
+
+  width = file_width;
+  height = file_height;
+  fingerprint = file_fingerprint;
+  seed = file_seed;
+  sum.swap(file_sum);
+  luminance_sq_sum.swap(file_sq_sum);
+  sample_count.swap(file_count);
+  streams.swap(file_streams);
+  return true;
+}
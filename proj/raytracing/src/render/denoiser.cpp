@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include <render/denoiser.hpp>
+#include <render/timeline.hpp>
+
+namespace {
+
+// B3-spline weights for tap offsets 0, 1 and 2
+constexpr double kernel_weights[3] = {3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0};
+// Albedo channels darker than this are not divided out, so near-black surfaces do
+// not turn their noise into huge irradiance values.
+constexpr double min_albedo = 1e-3;
+
+}
+
+// aov_buffer method definitions
+void aov_buffer::reset(int _width, int _height) {
+  width = _width;
+  height = _height;
+  const size_t pixel_count = static_cast<size_t>(width) * height;
+  albedo.assign(pixel_count, color(0, 0, 0));
+  normal.assign(pixel_count, vec3(0, 0, 0));
+  depth.assign(pixel_count, 0.0);
+}
+
+// denoiser method definitions
+void denoiser::apply(std::vector<color>& image, const std::vector<double>& variance, const aov_buffer& aovs) const {
+  trace_span span("denoise", "render");
+  const int width = aovs.width;
+  const int height = aovs.height;
+  const size_t pixel_count = static_cast<size_t>(width) * height;
+
+  // Demodulate: filter irradiance = radiance / albedo, and its luminance variance.
+  std::vector<color> albedo(pixel_count);
+  std::vector<color> irradiance(pixel_count);
+  std::vector<double> irradiance_variance(pixel_count);
+  for (size_t p = 0; p < pixel_count; ++p) {
+    const color& a = aovs.albedo[p];
+    albedo[p] = color(a.x() > min_albedo ? a.x() : 1, a.y() > min_albedo ? a.y() : 1, a.z() > min_albedo ? a.z() : 1);
+    irradiance[p] = color(image[p].x() / albedo[p].x(), image[p].y() / albedo[p].y(), image[p].z() / albedo[p].z());
+    double v = variance[p];
+    if (!std::isfinite(v)) {
+      // One sample: assume the noise is as large as the value itself.
+      v = luminance(image[p]) * luminance(image[p]);
+    }
+    const double scale = luminance(albedo[p]);
+    irradiance_variance[p] = v / (scale * scale);
+  }
+
+  std::vector<color> filtered(pixel_count);
+  std::vector<double> filtered_variance(pixel_count);
+  std::vector<double> smoothed_variance(pixel_count);
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    const int step = 1 << iteration;
+
+    // The luminance weight uses 3x3-blurred variance: single-pixel estimates are
+    // themselves noisy at low sample counts.
+    parallel_rows(height, [&](int begin, int end) {
+      for (int i = begin; i < end; ++i) {
+        for (int j = 0; j < width; ++j) {
+          double sum = 0;
+          double weight_sum = 0;
+          for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+              const int y = i + dy;
+              const int x = j + dx;
+              if (y < 0 || y >= height || x < 0 || x >= width) {
+                continue;
+              }
+              const double w = (dx == 0 ? 0.5 : 0.25) * (dy == 0 ? 0.5 : 0.25);
+              sum += w * irradiance_variance[static_cast<size_t>(y) * width + x];
+              weight_sum += w;
+            }
+          }
+          smoothed_variance[static_cast<size_t>(i) * width + j] = sum / weight_sum;
+        }
+      }
+    });
+
+    parallel_rows(height, [&](int begin, int end) {
+      for (int i = begin; i < end; ++i) {
+        for (int j = 0; j < width; ++j) {
+          const size_t p = static_cast<size_t>(i) * width + j;
+          const double center_luminance = luminance(irradiance[p]);
+          const double luminance_scale = sigma_luminance * std::sqrt(smoothed_variance[p]) + 1e-10;
+          const double center_depth = aovs.depth[p];
+          const double depth_scale = sigma_depth * step * center_depth + 1e-10;
+          const vec3& center_normal = aovs.normal[p];
+
+          color sum(0, 0, 0);
+          double weight_sum = 0;
+          double variance_sum = 0;
+          for (int dy = -2; dy <= 2; ++dy) {
+            const int y = i + dy * step;
+            if (y < 0 || y >= height) {
+              continue;
+            }
+            for (int dx = -2; dx <= 2; ++dx) {
+              const int x = j + dx * step;
+              if (x < 0 || x >= width) {
+                continue;
+              }
+              const size_t q = static_cast<size_t>(y) * width + x;
+
+              double exponent = std::abs(center_luminance - luminance(irradiance[q])) / luminance_scale;
+              // Sky only mixes with sky, surfaces only with surfaces.
+              if ((center_depth > 0) != (aovs.depth[q] > 0)) {
+                continue;
+              }
+              if (center_depth > 0 && q != p) {
+                const double cos_normals = dot(center_normal, aovs.normal[q]);
+                if (cos_normals <= 0) {
+                  continue;
+                }
+                exponent += sigma_normal * std::max(0.0, 1.0 - cos_normals);
+                exponent += std::abs(center_depth - aovs.depth[q]) / depth_scale;
+              }
+
+              const double w = kernel_weights[std::abs(dx)] * kernel_weights[std::abs(dy)] * std::exp(-exponent);
+              sum += w * irradiance[q];
+              weight_sum += w;
+              variance_sum += w * w * irradiance_variance[q];
+            }
+          }
+          // The center tap's weight is its kernel weight alone, so weight_sum > 0.
+          filtered[p] = sum / weight_sum;
+          filtered_variance[p] = variance_sum / (weight_sum * weight_sum);
+        }
+      }
+    });
+
+    std::swap(irradiance, filtered);
+    std::swap(irradiance_variance, filtered_variance);
+  }
+
+  for (size_t p = 0; p < pixel_count; ++p) {
+    image[p] = irradiance[p] * albedo[p];
+  }
+}
+
+void denoiser::parallel_rows(int height, const std::function<void(int, int)>& fn) const {
+  const int chunks = std::max(1, std::min(thread_count, height));
+  if (chunks == 1) {
+    fn(0, height);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(chunks);
+  for (int c = 0; c < chunks; ++c) {
+    int begin = static_cast<int>(static_cast<long long>(height) * c / chunks);
+    int end = static_cast<int>(static_cast<long long>(height) * (c + 1) / chunks);
+    threads.emplace_back([&fn, begin, end]() { fn(begin, end); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
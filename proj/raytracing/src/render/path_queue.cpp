@@ -0,0 +1,55 @@
+#include <render/path_queue.hpp>
+
+// path_queue method definitions
+void path_queue::reserve(size_t capacity) {
+  if(origin_x.size() >= capacity) {
+    return;
+  }
+  for(auto* lane : {&origin_x, &origin_y, &origin_z, &direction_x, &direction_y, &direction_z,
+                    &throughput_r, &throughput_g, &throughput_b, &radiance_r, &radiance_g, &radiance_b}) {
+    lane->resize(capacity);
+  }
+  scatter_pdf.resize(capacity);
+  local_pixel.resize(capacity);
+  image_pixel.resize(capacity);
+  sample.resize(capacity);
+  bounce.resize(capacity);
+  rec.resize(capacity);
+}
+
+size_t path_queue::push(const ray& r, const color& throughput, const color& radiance, double pdf, int local,
+                        uint32_t pixel, uint32_t sample_index, uint32_t bounces) {
+  const size_t slot = count++;
+  origin_x[slot] = r.origin().x();
+  origin_y[slot] = r.origin().y();
+  origin_z[slot] = r.origin().z();
+  direction_x[slot] = r.direction().x();
+  direction_y[slot] = r.direction().y();
+  direction_z[slot] = r.direction().z();
+  throughput_r[slot] = throughput.x();
+  throughput_g[slot] = throughput.y();
+  throughput_b[slot] = throughput.z();
+  radiance_r[slot] = radiance.x();
+  radiance_g[slot] = radiance.y();
+  radiance_b[slot] = radiance.z();
+  scatter_pdf[slot] = pdf;
+  local_pixel[slot] = local;
+  image_pixel[slot] = pixel;
+  sample[slot] = sample_index;
+  bounce[slot] = bounces;
+  return slot;
+}
+
+ray path_queue::path_ray(size_t slot) const {
+  return ray(point3(origin_x[slot], origin_y[slot], origin_z[slot]),
+             vec3(direction_x[slot], direction_y[slot], direction_z[slot]));
+}
+
+color path_queue::path_throughput(size_t slot) const {
+  return color(throughput_r[slot], throughput_g[slot], throughput_b[slot]);
+}
+
+
+color path_queue::path_radiance(size_t slot) const {
+  return color(radiance_r[slot], radiance_g[slot], radiance_b[slot]);
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <fstream>
+#include <iomanip>
+
+#include <render/render_stats.hpp>
+
+namespace {
+
+struct counter_name {
+  stat_counter counter;
+  const char* name;
+};
+
+const counter_name intersection_names[] = {
+  {stat_counter::sphere_tests, "sphere"},
+  {stat_counter::box_tests, "box"},
+  {stat_counter::plane_tests, "plane"},
+  {stat_counter::quad_tests, "quad"},
+  {stat_counter::triangle_tests, "triangle"},
+  {stat_counter::instance_tests, "instance"},
+};
+
+const counter_name path_names[] = {
+  {stat_counter::paths_escaped, "escaped"},
+  {stat_counter::paths_max_depth, "max_depth"},
+  {stat_counter::paths_absorbed, "absorbed"},
+  {stat_counter::paths_roulette, "roulette"},
+};
+
+uint64_t get(const thread_stats& s, stat_counter counter) {
+  return s.counters[static_cast<int>(counter)];
+}
+
+// Histogram without the empty tail
+int used_path_lengths(const thread_stats& s) {
+  int used = thread_stats::max_path_length + 1;
+  while (used > 0 && s.path_length[used - 1] == 0) --used;
+  return used;
+}
+
+}
+
+// thread_stats method definitions
+void thread_stats::add(const thread_stats& other) {
+  for (int k = 0; k < static_cast<int>(stat_counter::count); ++k) {
+    counters[k] += other.counters[k];
+  }
+  for (int k = 0; k <= max_path_length; ++k) {
+    path_length[k] += other.path_length[k];
+  }
+  tiles += other.tiles;
+  busy_seconds += other.busy_seconds;
+  idle_seconds += other.idle_seconds;
+}
+
+// render_stats method definitions
+void render_stats::reset(int worker_count) {
+  workers.assign(static_cast<size_t>(worker_count), thread_stats());
+}
+
+thread_stats render_stats::total() const {
+  thread_stats sum;
+  for (const thread_stats& w : workers) {
+    sum.add(w);
+  }
+  return sum;
+}
+
+void render_stats::print(std::ostream& out) const {
+  const thread_stats sum = total();
+  const uint64_t primary = get(sum, stat_counter::primary_rays);
+  const uint64_t secondary = get(sum, stat_counter::secondary_rays);
+  const uint64_t shadow = get(sum, stat_counter::shadow_rays);
+  const uint64_t rays = primary + secondary + shadow;
+
+  out << "Render statistics\n";
+  out << "  rays: " << rays << " (" << primary << " primary, " << secondary << " secondary, " << shadow
+      << " shadow)\n";
+  out << "  BVH nodes visited: " << get(sum, stat_counter::bvh_nodes_visited);
+  if (rays > 0) out << " (" << std::fixed << std::setprecision(1)
+                    << static_cast<double>(get(sum, stat_counter::bvh_nodes_visited)) / rays << " per ray)";
+  out << "\n  intersection tests:";
+  for (const counter_name& c : intersection_names) {
+    out << " " << c.name << " " << get(sum, c.counter);
+  }
+  out << "\n  paths:";
+  for (const counter_name& c : path_names) {
+    out << " " << c.name << " " << get(sum, c.counter);
+  }
+  out << "\n  path length:";
+  for (int k = 1; k < used_path_lengths(sum); ++k) {
+    out << " " << k << (k == thread_stats::max_path_length ? "+" : "") << ":" << sum.path_length[k];
+  }
+  out << "\n";
+  for (size_t id = 0; id < workers.size(); ++id) {
+    const thread_stats& w = workers[id];
+    const double wall = w.busy_seconds + w.idle_seconds;
+    out << "  thread " << id << ": " << w.tiles << " tiles, busy " << std::fixed << std::setprecision(3)
+        << w.busy_seconds << " s, idle " << w.idle_seconds << " s";
+    if (wall > 0) out << " (" << std::setprecision(1) << 100.0 * w.busy_seconds / wall << "% busy)";
+    out << "\n";
+  }
+  out << std::defaultfloat << std::flush;
+}
+
+bool render_stats::write_json(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+
+  const thread_stats sum = total();
+  out << "{\n";
+  out << "  \"rays\": {\"primary\": " << get(sum, stat_counter::primary_rays)
+      << ", \"secondary\": " << get(sum, stat_counter::secondary_rays)
+      << ", \"shadow\": " << get(sum, stat_counter::shadow_rays) << "},\n";
+  out << "  \"bvh_nodes_visited\": " << get(sum, stat_counter::bvh_nodes_visited) << ",\n";
+  out << "  \"intersection_tests\": {";
+  for (const counter_name& c : intersection_names) {
+    out << (&c == intersection_names ? "" : ", ") << "\"" << c.name << "\": " << get(sum, c.counter);
+  }
+  out << "},\n  \"paths\": {";
+  for (const counter_name& c : path_names) {
+    out << (&c == path_names ? "" : ", ") << "\"" << c.name << "\": " << get(sum, c.counter);
+  }
+  out << "},\n  \"path_length_histogram\": [";
+  for (int k = 0; k < used_path_lengths(sum); ++k) {
+    out << (k ? ", " : "") << sum.path_length[k];
+  }
+  out << "],\n  \"threads\": [\n";
+  for (size_t id = 0; id < workers.size(); ++id) {
+    const thread_stats& w = workers[id];
+    out << "    {\"id\": " << id << ", \"tiles\": " << w.tiles << ", \"busy_seconds\": " << w.busy_seconds
+        << ", \"idle_seconds\": " << w.idle_seconds << ", \"rays\": "
+        << get(w, stat_counter::primary_rays) + get(w, stat_counter::secondary_rays)
+           + get(w, stat_counter::shadow_rays) << "}"
+        << (id + 1 < workers.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <render/sampler.hpp>
+
+namespace {
+
+constexpr int blue_noise_size = 64;
+
+// SplitMix64 finalizer, as in rng_stream
+uint64_t mix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Chris Wellons' lowbias32 integer hash
+uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x21f0aaad;
+  x ^= x >> 15;
+  x *= 0x735a2d97;
+  x ^= x >> 15;
+  return x;
+}
+
+uint32_t reverse_bits(uint32_t x) {
+  x = (x << 16) | (x >> 16);
+  x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+  x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+  x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+  x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+  return x;
+}
+
+double to_unit(uint32_t x) {
+  return x * 0x1.0p-32;
+}
+
+// Owen scrambling of a 32-bit fixed-point value: every bit is flipped or not
+// depending on the bits above it. Hash-based form of Burley, "Practical
+// Hash-based Owen Scrambling" (JCGT 2020), with Vegdahl's improved permutation.
+uint32_t owen_scramble(uint32_t x, uint32_t seed) {
+  x = reverse_bits(x);
+  x ^= x * 0x3d20adea;
+  x += seed;
+  x *= (seed >> 16) | 1;
+  x ^= x * 0x05526c56;
+  x ^= x * 0x53a22864;
+  return reverse_bits(x);
+}
+
+// Coordinate axis of point index of the first two Sobol dimensions: van der
+// Corput, and the dimension with primitive polynomial x + 1, whose direction
+// numbers are v_k = v_(k-1) ^ (v_(k-1) >> 1).
+uint32_t sobol(uint32_t index, uint32_t axis) {
+  if (axis == 0) {
+    return reverse_bits(index);
+  }
+  uint32_t result = 0;
+  for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1) {
+    if (index & 1) {
+      result ^= v;
+    }
+  }
+  return result;
+}
+
+// Point `index` of a shuffled, Owen-scrambled 2D Sobol sequence. Scrambling the
+// index keeps every power-of-two prefix a (0, 2)-net while giving each seed its
+// own point order, so dimension pairs with different seeds are decorrelated.
+uint32_t scrambled_sobol(uint32_t index, uint32_t axis, uint32_t seed) {
+  const uint32_t shuffled = owen_scramble(index, seed);
+  return owen_scramble(sobol(shuffled, axis), hash32(seed ^ (axis + 1) * 0x9e3779b9u));
+}
+
+// Kensler's hash-based permutation of [0, length) ("Correlated Multi-Jittered
+// Sampling", 2013)
+uint32_t permute(uint32_t i, uint32_t length, uint32_t seed) {
+  uint32_t w = length - 1;
+  w |= w >> 1;
+  w |= w >> 2;
+  w |= w >> 4;
+  w |= w >> 8;
+  w |= w >> 16;
+  do {
+    i ^= seed;
+    i *= 0xe170893d;
+    i ^= seed >> 16;
+    i ^= (i & w) >> 4;
+    i ^= seed >> 8;
+    i *= 0x0929eb3f;
+    i ^= seed >> 23;
+    i ^= (i & w) >> 1;
+    i *= 1 | seed >> 27;
+    i *= 0x6935fa69;
+    i ^= (i & w) >> 11;
+    i *= 0x74dcb303;
+    i ^= (i & w) >> 2;
+    i *= 0x9e501cc3;
+    i ^= (i & w) >> 2;
+    i *= 0xc860a3df;
+    i &= w;
+    i ^= i >> 5;
+  } while (i >= length);
+  return (i + seed) % length;
+}
+
+// Ranks 0..size*size-1 of a tileable blue-noise dither mask, by Ulichney's
+// void-and-cluster method: ranks are given out by repeatedly removing the point
+// in the tightest cluster or filling the largest void, measured with a toroidal
+// Gaussian energy.
+std::vector<uint16_t> make_blue_noise(int size) {
+  const int n = size * size;
+  const double sigma = 1.5;
+  std::vector<float> kernel(n);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      const int dx = std::min(x, size - x);
+      const int dy = std::min(y, size - y);
+      kernel[y * size + x] = static_cast<float>(std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma)));
+    }
+  }
+
+  std::vector<uint8_t> on(n, 0);
+  std::vector<float> energy(n, 0.0f);
+  auto set = [&](int p, bool value) {
+    on[p] = value;
+    const float sign = value ? 1.0f : -1.0f;
+    const int px = p % size;
+    const int py = p / size;
+    for (int y = 0; y < size; ++y) {
+      const int row = ((y - py + size) % size) * size;
+      for (int x = 0; x < size; ++x) {
+        energy[y * size + x] += sign * kernel[row + (x - px + size) % size];
+      }
+    }
+  };
+  auto tightest_cluster = [&]() {
+    int best = -1;
+    for (int p = 0; p < n; ++p) {
+      if (on[p] && (best < 0 || energy[p] > energy[best])) best = p;
+    }
+    return best;
+  };
+  auto largest_void = [&]() {
+    int best = -1;
+    for (int p = 0; p < n; ++p) {
+      if (!on[p] && (best < 0 || energy[p] < energy[best])) best = p;
+    }
+    return best;
+  };
+
+  // Initial binary pattern: a tenth of the cells at random, then evened out by
+  // moving the tightest cluster's point into the largest void until that stops
+  // changing anything.
+  uint64_t state = 0x2545f4914f6cdd1dull;
+  int ones = 0;
+  while (ones < n / 10) {
+    state = mix64(state + 0x9e3779b97f4a7c15ull);
+    const int p = static_cast<int>(state % static_cast<uint64_t>(n));
+    if (!on[p]) {
+      set(p, true);
+      ++ones;
+    }
+  }
+  for (int step = 0; step < n; ++step) {
+    const int cluster = tightest_cluster();
+    set(cluster, false);
+    const int hole = largest_void();
+    set(hole, true);
+    if (hole == cluster) {
+      break;
+    }
+  }
+  const std::vector<uint8_t> prototype = on;
+  const std::vector<float> prototype_energy = energy;
+
+  std::vector<uint16_t> rank(n);
+  // Ranks below the prototype's point count: remove points, tightest cluster first
+  for (int count = ones; count > 0; --count) {
+    const int cluster = tightest_cluster();
+    set(cluster, false);
+    rank[cluster] = static_cast<uint16_t>(count - 1);
+  }
+  // The rest: fill voids, largest first. Past half full this is the same as
+  // taking the tightest cluster of the remaining empty cells.
+  on = prototype;
+  energy = prototype_energy;
+  for (int count = ones; count < n; ++count) {
+    const int hole = largest_void();
+    set(hole, true);
+    rank[hole] = static_cast<uint16_t>(count);
+  }
+  return rank;
+}
+
+const std::vector<uint16_t>& blue_noise_mask() {
+  static const std::vector<uint16_t> mask = make_blue_noise(blue_noise_size);
+  return mask;
+}
+
+}
+
+// sampler method definitions
+sampler::sampler(sampler_kind kind, int samples_per_pixel, int image_width)
+  : pattern(kind), width(static_cast<uint32_t>(std::max(1, image_width))) {
+  // The largest near-square grid with at most samples_per_pixel cells
+  const int samples = std::max(1, samples_per_pixel);
+  strata_x = static_cast<uint32_t>(std::max(1, static_cast<int>(std::sqrt(static_cast<double>(samples)))));
+  strata_y = static_cast<uint32_t>(samples) / strata_x;
+  if (kind == sampler_kind::blue_noise) {
+    blue_noise_mask();
+  }
+}
+
+double sampler::value(uint64_t seed, uint64_t pixel, uint32_t sample, uint32_t bounce, uint32_t dimension) const {
+  const uint32_t axis = dimension & 1;
+  const uint64_t pair = (static_cast<uint64_t>(bounce) << 32) | (dimension >> 1);
+  const uint64_t image_key = mix64(mix64(seed ^ 0x5851f42d4c957f2dull) ^ pair);
+  if (pattern == sampler_kind::blue_noise) {
+    return blue_noise(static_cast<uint32_t>(image_key), pixel, sample, axis);
+  }
+  const uint64_t pixel_key = mix64(image_key ^ (pixel * 0x9e3779b97f4a7c15ull));
+  switch (pattern) {
+  case sampler_kind::stratified:
+    return stratified(static_cast<uint32_t>(pixel_key), sample, axis);
+  case sampler_kind::sobol:
+    return to_unit(scrambled_sobol(sample, axis, static_cast<uint32_t>(pixel_key)));
+  default:
+    return to_unit(static_cast<uint32_t>(mix64(pixel_key ^ (static_cast<uint64_t>(sample) << 1 | axis)) >> 32));
+  }
+}
+
+double sampler::stratified(uint32_t scramble, uint32_t sample, uint32_t axis) const {
+  const uint32_t strata = strata_x * strata_y;
+  // Every run of `strata` samples visits all cells once, in its own order
+  const uint32_t round = sample / strata;
+  const uint32_t cell = permute(sample % strata, strata, hash32(scramble + round * 0x9e3779b9u));
+  const uint32_t jitter = hash32(hash32(scramble ^ sample * 0x85ebca6bu) + axis);
+  return axis == 0 ? (cell % strata_x + to_unit(jitter)) / strata_x
+                   : (cell / strata_x + to_unit(jitter)) / strata_y;
+}
+
+double sampler::blue_noise(uint32_t scramble, uint64_t pixel, uint32_t sample, uint32_t axis) const {
+  // Each dimension reads the mask at its own toroidal offset, so dimensions do
+  // not share a dither pattern.
+  const uint32_t offset = hash32(scramble + axis);
+  const uint32_t x = static_cast<uint32_t>(pixel % width) + (offset & 0xffff);
+  const uint32_t y = static_cast<uint32_t>(pixel / width) + (offset >> 16);
+  const uint32_t mask_rank = blue_noise_mask()[(y % blue_noise_size) * blue_noise_size + x % blue_noise_size];
+  const double shift = (mask_rank + 0.5) / (blue_noise_size * blue_noise_size);
+  const double u = to_unit(scrambled_sobol(sample, axis, scramble)) + shift;
+  return u < 1.0 ? u : u - 1.0;
+}
+
+bool sampler::parse(const std::string& name, sampler_kind& kind) {
+  if (name == "independent") {
+    kind = sampler_kind::independent;
+  } else if (name == "stratified") {
+    kind = sampler_kind::stratified;
+  } else if (name == "sobol") {
+    kind = sampler_kind::sobol;
+  } else if (name == "bluenoise") {
+    kind = sampler_kind::blue_noise;
+  } else {
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cstdint>
+
+#include <render/tile_scheduler.hpp>
+
+namespace {
+
+// Interleaves the low 16 bits of x and y into a Z-order index.
+uint32_t morton_code(uint32_t x, uint32_t y) {
+  auto spread = [](uint32_t v) {
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+  };
+  return spread(x) | (spread(y) << 1);
+}
+
+}
+
+// tile_scheduler method definitions
+tile_scheduler::tile_scheduler(int image_width, int image_height, int tile_size, int thread_count, int part,
+                               int part_count)
+  : queues(std::max(1, thread_count)) {
+  part_count = std::max(1, part_count);
+  tile_size = std::max(1, tile_size);
+  const int tiles_x = (image_width + tile_size - 1) / tile_size;
+  const int tiles_y = (image_height + tile_size - 1) / tile_size;
+
+  struct ordered_tile {
+    uint32_t code;
+    tile t;
+  };
+  std::vector<ordered_tile> ordered;
+  ordered.reserve(static_cast<size_t>(tiles_x) * tiles_y);
+  for (int ty = 0; ty < tiles_y; ++ty) {
+    for (int tx = 0; tx < tiles_x; ++tx) {
+      tile t{tx * tile_size, ty * tile_size,
+             std::min(image_width, (tx + 1) * tile_size), std::min(image_height, (ty + 1) * tile_size)};
+      ordered.push_back({morton_code(tx, ty), t});
+    }
+  }
+  std::sort(ordered.begin(), ordered.end(), [](const ordered_tile& a, const ordered_tile& b) { return a.code < b.code; });
+
+  if (part_count > 1) {
+    size_t kept = 0;
+    for (size_t k = part; k < ordered.size(); k += part_count) {
+      ordered[kept++] = ordered[k];
+    }
+    ordered.resize(kept);
+  }
+  for (const ordered_tile& o : ordered) {
+    total_pixels += o.t.pixel_count();
+  }
+
+  total_tiles = ordered.size();
+  const size_t queue_count = queues.size();
+  for (size_t q = 0; q < queue_count; ++q) {
+    size_t begin = total_tiles * q / queue_count;
+    size_t end = total_tiles * (q + 1) / queue_count;
+    for (size_t k = begin; k < end; ++k) {
+      queues[q].tiles.push_back(ordered[k].t);
+    }
+  }
+}
+
+bool tile_scheduler::next(int thread_id, tile& out) {
+  worker_queue& own = queues[thread_id % queues.size()];
+  {
+    std::lock_guard<std::mutex> guard(own.lock);
+    if (!own.tiles.empty()) {
+      out = own.tiles.front();
+      own.tiles.pop_front();
+      return true;
+    }
+  }
+  return steal(thread_id, out);
+}
+
+size_t tile_scheduler::tile_count() const {
+  return total_tiles;
+}
+
+size_t tile_scheduler::pixel_count() const {
+  return total_pixels;
+}
+
+bool tile_scheduler::steal(int thief_id, tile& out) {
+  const size_t queue_count = queues.size();
+  for (size_t k = 1; k < queue_count; ++k) {
+    worker_queue& victim = queues[(thief_id + k) % queue_count];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (!victim.tiles.empty()) {
+      // Take from the far end of the victim's run, away from where it is working.
+      out = victim.tiles.back();
+      victim.tiles.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
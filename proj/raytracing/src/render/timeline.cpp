@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <render/timeline.hpp>
+
+namespace {
+
+struct trace_event {
+  const char* name;
+  const char* category;
+  int64_t begin_ns;
+  int64_t end_ns;
+  timeline::detail kind;
+  int32_t values[4];
+};
+
+struct thread_buffer {
+  std::string name;
+  int tid;
+  std::vector<trace_event> events;
+};
+
+std::mutex registry_lock;
+std::vector<std::unique_ptr<thread_buffer>> buffers;
+std::chrono::steady_clock::time_point epoch;
+
+thread_buffer*& current_buffer() {
+  thread_local thread_buffer* buffer = nullptr;
+  return buffer;
+}
+
+thread_buffer* find_or_add(const std::string& name) {
+  std::lock_guard<std::mutex> guard(registry_lock);
+  for (auto& buffer : buffers) {
+    if (buffer->name == name) return buffer.get();
+  }
+  buffers.push_back(std::make_unique<thread_buffer>());
+  thread_buffer* buffer = buffers.back().get();
+  buffer->name = name;
+  buffer->tid = static_cast<int>(buffers.size());
+  buffer->events.reserve(1024);
+  return buffer;
+}
+
+void write_string(std::ofstream& out, const std::string& text) {
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') out << '\\';
+    out << c;
+  }
+  out << '"';
+}
+
+}
+
+bool timeline::active = false;
+
+// timeline method definitions
+void timeline::start() {
+  epoch = std::chrono::steady_clock::now();
+  active = true;
+  name_thread("main");
+}
+
+void timeline::name_thread(const std::string& name) {
+  if (!active) return;
+  current_buffer() = find_or_add(name);
+}
+
+int64_t timeline::now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void timeline::record(const char* name, const char* category, int64_t begin_ns, int64_t end_ns, detail kind,
+                      const int32_t* values) {
+  thread_buffer*& buffer = current_buffer();
+  if (!buffer) {
+    // Threads that never named themselves get a row of their own.
+    static int unnamed = 0;
+    std::string thread_name;
+    {
+      std::lock_guard<std::mutex> guard(registry_lock);
+      thread_name = "thread " + std::to_string(++unnamed);
+    }
+    buffer = find_or_add(thread_name);
+  }
+
+  trace_event event{name, category, begin_ns, end_ns, kind, {}};
+  std::copy(values, values + 4, event.values);
+  buffer->events.push_back(event);
+}
+
+bool timeline::write(const std::string& path) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(registry_lock);
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  bool first = true;
+  auto separator = [&]() {
+    out << (first ? "" : ",\n");
+    first = false;
+  };
+
+  for (const auto& buffer : buffers) {
+    separator();
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+        << ", \"args\": {\"name\": ";
+    write_string(out, buffer->name);
+    out << "}}";
+    separator();
+    out << "{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+        << ", \"args\": {\"sort_index\": " << buffer->tid << "}}";
+  }
+
+  // Timestamps in microseconds, as the format expects, keeping ns resolution
+  auto write_us = [&](int64_t ns) {
+    out << ns / 1000 << "." << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+  };
+  for (const auto& buffer : buffers) {
+    for (const trace_event& e : buffer->events) {
+      separator();
+      out << "{\"name\": \"" << e.name << "\", \"cat\": \"" << e.category << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+          << buffer->tid << ", \"ts\": ";
+      write_us(e.begin_ns);
+      out << ", \"dur\": ";
+      write_us(e.end_ns - e.begin_ns);
+      if (e.kind == detail::tile) {
+        out << ", \"args\": {\"x0\": " << e.values[0] << ", \"y0\": " << e.values[1] << ", \"x1\": " << e.values[2]
+            << ", \"y1\": " << e.values[3] << "}";
+      } else if (e.kind == detail::index) {
+        out << ", \"args\": {\"index\": " << e.values[0] << "}";
+      }
+      out << "}";
+    }
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
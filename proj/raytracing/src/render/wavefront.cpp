@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstdint>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <objects/camera.hpp>
+#include <objects/hittable.hpp>
+
+#include <materials/material_table.hpp>
+
+#include <constants.hpp>
+#include <randomizer.hpp>
+#include <render/path_queue.hpp>
+#include <render/render_stats.hpp>
+
+// Wavefront integrator: instead of following one path to completion, a tile keeps
+// up to wavefront_size paths in flight and advances all of them a bounce at a
+// time in separate stages:
+//   1. generation   - top the queue up with camera rays for samples still owed
+//   2. intersection - trace every queued ray; misses finish with the sky colour
+//   3. shading      - add emission, sample lights and scatter the hits grouped
+//                     by material type and id, so each material's code and data
+//                     stay hot, writing the surviving paths into the next queue
+// Every path restarts its own random stream before each stage that draws numbers,
+// so for the same seed the image matches the recursive integrator up to rounding.
+void camera::render_tile_wavefront(const tile& t, const hittable& world, const accumulation_buffer& accum,
+                                   int pass_samples, accumulation_buffer& local) const {
+  const size_t capacity = static_cast<size_t>(std::max(ray_packet::size, wavefront_size));
+  path_queue current, next;
+  current.reserve(capacity);
+  next.reserve(capacity);
+
+  // Generation cursor: pixel (in tile order) and how many of its samples are queued
+  int cursor = 0;
+  int cursor_queued = 0;
+  int cursor_samples = -1;
+
+  auto generate = [&](path_queue& queue) {
+    while(queue.size() < capacity && cursor < t.pixel_count()) {
+      const int i = t.y0 + cursor / t.width();
+      const int j = t.x0 + cursor % t.width();
+      if(cursor_samples < 0) {
+        cursor_samples = pixel_pass_samples(accum, i, j, pass_samples);
+      }
+      if(cursor_queued == cursor_samples) {
+        ++cursor;
+        cursor_queued = 0;
+        cursor_samples = -1;
+        continue;
+      }
+
+      const uint32_t pixel = static_cast<uint32_t>(i * image_width + j);
+      const uint32_t sample = accum.sample_count[pixel] + cursor_queued++;
+      if(max_depth <= 0) {
+        local.add_sample(cursor, color(0, 0, 0));
+        continue;
+      }
+      start_sample(i, j, sample);
+      queue.push(get_ray(i, j), color(1, 1, 1), color(0, 0, 0), 0.0, cursor, pixel, sample, 0);
+    }
+  };
+
+  struct shade_key {
+    size_t type;
+    material_id mat;
+    uint32_t slot;
+  };
+  std::vector<shade_key> shade_order;
+  shade_order.reserve(capacity);
+
+  generate(current);
+  while(current.size() > 0) {
+    // Intersection
+    shade_order.clear();
+    for(size_t slot=0; slot<current.size(); ++slot) {
+      const ray r = current.path_ray(slot);
+      hit_record& rec = current.rec[slot];
+      if(world.hit(r, interval(0.001, INF), rec)) {
+        const size_t type = rec.mat != no_material ? typeid((*materials)[rec.mat]).hash_code() : 0;
+        shade_order.push_back({type, rec.mat, static_cast<uint32_t>(slot)});
+      } else {
+        RT_STAT_END_PATH(paths_escaped, static_cast<int>(current.bounce[slot]) + 1);
+        local.add_sample(current.local_pixel[slot],
+                         current.path_radiance(slot) + current.path_throughput(slot) * background(r));
+      }
+    }
+
+    // Shading, one material at a time
+    std::sort(shade_order.begin(), shade_order.end(), [](const shade_key& a, const shade_key& b) {
+      if(a.type != b.type) return a.type < b.type;
+      if(a.mat != b.mat) return a.mat < b.mat;
+      return a.slot < b.slot;
+    });
+    next.clear();
+    for(const shade_key& key : shade_order) {
+      const size_t slot = key.slot;
+      const uint32_t pixel = current.image_pixel[slot];
+      const uint32_t bounces = current.bounce[slot] + 1;
+      start_sample(static_cast<int>(pixel / image_width), static_cast<int>(pixel % image_width), current.sample[slot]);
+      thread_rng().set_bounce(bounces);
+
+      // Same steps in the same order as trace_from_hit, so the random streams agree
+      const ray r = current.path_ray(slot);
+      const hit_record& rec = current.rec[slot];
+      color radiance = current.path_radiance(slot);
+      const color emitted = materials->emitted(key.mat, rec);
+      if(emitted.x() > 0 || emitted.y() > 0 || emitted.z() > 0) {
+        radiance += current.path_throughput(slot) * emitted * emission_weight(r, current.scatter_pdf[slot]);
+      }
+
+      ray scattered;
+      color attenuation;
+      const bool scatters = materials->scatter(key.mat, r, rec, attenuation, scattered);
+      if(!scatters || static_cast<int>(bounces) >= max_depth) {
+        if(!scatters) {
+          RT_STAT_END_PATH(paths_absorbed, static_cast<int>(bounces));
+        } else {
+          RT_STAT_END_PATH(paths_max_depth, static_cast<int>(bounces));
+        }
+        local.add_sample(current.local_pixel[slot], radiance);
+        continue;
+      }
+      double scatter_pdf = 0;
+      if(lights != nullptr) {
+        scatter_pdf = materials->scattering_pdf(key.mat, r, rec, scattered.direction());
+        if(scatter_pdf > 0) {
+          radiance += current.path_throughput(slot) * sample_lights(r, rec, world);
+        }
+      }
+      color throughput = current.path_throughput(slot) * attenuation;
+      if(!survives_roulette(static_cast<int>(bounces), throughput)) {
+        RT_STAT_END_PATH(paths_roulette, static_cast<int>(bounces));
+        local.add_sample(current.local_pixel[slot], radiance);
+        continue;
+      }
+      RT_STAT_INC(secondary_rays);
+      next.push(scattered, throughput, radiance, scatter_pdf, current.local_pixel[slot], pixel, current.sample[slot],
+                bounces);
+    }
+
+    // Surviving paths carry on; free slots go to new camera samples
+    std::swap(current, next);
+    generate(current);
+  }
+}
@@ -0,0 +1,610 @@
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <scene/scene.hpp>
+
+#include <objects/instance.hpp>
+#include <objects/transform.hpp>
+
+#include <io/mapped_file.hpp>
+
+#include <render/timeline.hpp>
+
+#include <materials/dielectric.hpp>
+#include <materials/diffuse_light.hpp>
+#include <materials/lambertian.hpp>
+#include <materials/metal.hpp>
+
+#include <shapes/box.hpp>
+#include <shapes/plane.hpp>
+#include <shapes/quad.hpp>
+#include <shapes/sphere.hpp>
+#include <shapes/sphere_set.hpp>
+#include <shapes/triangle_mesh.hpp>
+
+namespace {
+
+const char cache_magic[4] = {'R', 'T', 'S', 'C'};
+const uint32_t cache_version = 5;
+
+// Spheres more than this many times the median radius (typically a ground made of
+// one huge sphere) stay separate objects, so they do not stretch a sphere_set's box
+// over the whole scene.
+const double huge_sphere_ratio = 8;
+
+// Compiled scene layout: this header, then the material, sphere, box, plane, quad,
+// mesh and instance records in that order. Every record is a multiple of 8 bytes, so
+// the arrays stay aligned inside the page-aligned mapping.
+struct cache_header {
+  char magic[4];
+  uint32_t version;
+  uint64_t source_size;
+  int64_t source_mtime;
+  scene_view view;
+  uint64_t material_count;
+  uint64_t sphere_count;
+  uint64_t box_count;
+  uint64_t plane_count;
+  uint64_t quad_count;
+  uint64_t mesh_count;
+  uint64_t instance_count;
+};
+
+// FNV-1a over size bytes, continuing from hash
+uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t k = 0; k < size; ++k) {
+    hash ^= bytes[k];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// Reorders spheres[begin, end) into spatial clusters of at most cluster_size by
+// splitting at the median center along the longest axis of the centers, and
+// appends each cluster's range to clusters.
+void cluster_spheres(std::vector<const sphere_record*>& spheres, size_t begin, size_t end, size_t cluster_size,
+                     std::vector<std::pair<size_t, size_t>>& clusters) {
+  if (end - begin <= cluster_size) {
+    clusters.emplace_back(begin, end);
+    return;
+  }
+
+  double lo[3] = {INF, INF, INF};
+  double hi[3] = {-INF, -INF, -INF};
+  for (size_t k = begin; k < end; ++k) {
+    for (int axis = 0; axis < 3; ++axis) {
+      lo[axis] = std::min(lo[axis], spheres[k]->center[axis]);
+      hi[axis] = std::max(hi[axis], spheres[k]->center[axis]);
+    }
+  }
+  int axis = 0;
+  for (int a = 1; a < 3; ++a) {
+    if (hi[a] - lo[a] > hi[axis] - lo[axis]) axis = a;
+  }
+
+  const size_t middle = begin + (end - begin) / 2;
+  std::nth_element(spheres.begin() + begin, spheres.begin() + middle, spheres.begin() + end,
+                   [axis](const sphere_record* a, const sphere_record* b) { return a->center[axis] < b->center[axis]; });
+  cluster_spheres(spheres, begin, middle, cluster_size, clusters);
+  cluster_spheres(spheres, middle, end, cluster_size, clusters);
+}
+
+bool source_stamp(const std::string& path, uint64_t& size, int64_t& mtime) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return false;
+  }
+  size = static_cast<uint64_t>(info.st_size);
+#ifdef __APPLE__
+  mtime = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+  mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+  return true;
+}
+
+template <typename T>
+record_span<T> span_of(const std::vector<T>& records) {
+  return {records.data(), records.size()};
+}
+
+// Next count records of the mapping, advancing cursor past them
+template <typename T>
+record_span<T> take_records(const unsigned char*& cursor, uint64_t count) {
+  record_span<T> span{reinterpret_cast<const T*>(cursor), static_cast<size_t>(count)};
+  cursor += count * sizeof(T);
+  return span;
+}
+
+// Whether every record names one of material_count materials
+template <typename T>
+bool materials_in_range(record_span<T> records, size_t material_count) {
+  for (const T& record : records) {
+    if (record.material >= material_count) return false;
+  }
+  return true;
+}
+
+// Whether every path of records is terminated inside its field
+template <typename T>
+bool paths_terminated(record_span<T> records) {
+  for (const T& record : records) {
+    if (!std::memchr(record.path, '\0', sizeof(record.path))) return false;
+  }
+  return true;
+}
+
+template <typename T>
+void write_records(std::ofstream& out, const std::vector<T>& records) {
+  out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+}
+
+}
+
+// scene_view method definitions
+void scene_view::apply(camera& cam) const {
+  cam.aspect_ratio = aspect_ratio;
+  cam.image_width = image_width;
+  cam.samples_per_pixel = samples_per_pixel;
+  cam.max_depth = max_depth;
+  cam.look_from = point3(look_from[0], look_from[1], look_from[2]);
+  cam.look_at = point3(look_at[0], look_at[1], look_at[2]);
+  cam.v_up = vec3(v_up[0], v_up[1], v_up[2]);
+  cam.v_fov = v_fov;
+  cam.use_sky = use_sky != 0;
+  cam.background_color = color(background[0], background[1], background[2]);
+  cam.defocus_angle = defocus_angle;
+  cam.focus_dist = focus_dist;
+}
+
+// scene method definitions
+std::string scene::cache_path(const std::string& path) {
+  return path + ".bin";
+}
+
+bool scene::load(const std::string& path) {
+  trace_span span("load scene", "scene");
+  uint64_t source_size = 0;
+  int64_t source_mtime = 0;
+  if (!source_stamp(path, source_size, source_mtime)) {
+    std::cerr << path << ": cannot open scene" << std::endl;
+    return false;
+  }
+
+  const std::string compiled = cache_path(path);
+  bool built = false;
+  if (load_cache(path, compiled, source_size, source_mtime, built)) {
+    return built;
+  }
+
+  source data;
+  scene_view parsed_view;
+  if (!parse(path, parsed_view, data)) {
+    return false;
+  }
+  if (!write_cache(compiled, parsed_view, data, source_size, source_mtime)) {
+    std::cerr << "Could not write compiled scene " << compiled << std::endl;
+  }
+
+  view = parsed_view;
+  return build(path, span_of(data.materials), span_of(data.spheres), span_of(data.boxes), span_of(data.planes),
+               span_of(data.quads), span_of(data.meshes), span_of(data.instances));
+}
+
+bool scene::parse(const std::string& path, scene_view& view, source& out) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << path << ": cannot open scene" << std::endl;
+    return false;
+  }
+
+  std::unordered_map<std::string, uint32_t> material_names;
+  std::string line;
+  int line_number = 0;
+
+  while (std::getline(in, line)) {
+    ++line_number;
+    auto fail = [&](const std::string& message) {
+      std::cerr << path << ":" << line_number << ": " << message << std::endl;
+      return false;
+    };
+
+    line = line.substr(0, line.find('#'));
+    std::istringstream tokens(line);
+    std::string keyword;
+    if (!(tokens >> keyword)) {
+      continue;
+    }
+
+    auto numbers = [&](double* values, int count) {
+      for (int k = 0; k < count; ++k) {
+        if (!(tokens >> values[k])) return false;
+      }
+      return true;
+    };
+    auto material_ref = [&](uint32_t& index) {
+      std::string name;
+      if (!(tokens >> name)) return fail("expected a material name");
+      auto found = material_names.find(name);
+      if (found == material_names.end()) return fail("unknown material '" + name + "'");
+      index = found->second;
+      return true;
+    };
+    auto end_of_line = [&]() {
+      std::string extra;
+      return (tokens >> extra) ? fail("unexpected '" + extra + "'") : true;
+    };
+
+    if (keyword == "camera") {
+      std::string field;
+      tokens >> field;
+      double values[3];
+      bool ok = true;
+      if (field == "look_from" || field == "look_at" || field == "v_up") {
+        ok = numbers(values, 3);
+        double* target = field == "look_from" ? view.look_from : (field == "look_at" ? view.look_at : view.v_up);
+        std::copy(values, values + 3, target);
+      } else if (field == "background") {
+        ok = numbers(values, 3);
+        std::copy(values, values + 3, view.background);
+        view.use_sky = 0;
+      } else if (field == "aspect_ratio" || field == "v_fov" || field == "defocus_angle" || field == "focus_dist") {
+        ok = numbers(values, 1);
+        double& target = field == "v_fov" ? view.v_fov
+                       : field == "defocus_angle" ? view.defocus_angle
+                       : field == "focus_dist" ? view.focus_dist : view.aspect_ratio;
+        target = values[0];
+      } else if (field == "image_width" || field == "samples_per_pixel" || field == "max_depth") {
+        ok = numbers(values, 1);
+        int32_t& target = field == "image_width" ? view.image_width
+                        : (field == "samples_per_pixel" ? view.samples_per_pixel : view.max_depth);
+        target = static_cast<int32_t>(values[0]);
+      } else {
+        return fail("unknown camera field '" + field + "'");
+      }
+      if (!ok) return fail("bad value for camera " + field);
+    } else if (keyword == "material") {
+      std::string name, kind;
+      if (!(tokens >> name >> kind)) return fail("expected: material <name> <kind> <parameters>");
+      if (material_names.count(name)) return fail("material '" + name + "' defined twice");
+
+      material_record record{};
+      int parameter_count = 0;
+      if (kind == "lambertian") {
+        record.kind = material_kind::lambertian;
+        parameter_count = 3;
+      } else if (kind == "metal") {
+        record.kind = material_kind::metal;
+        parameter_count = 4;
+      } else if (kind == "dielectric") {
+        record.kind = material_kind::dielectric;
+        parameter_count = 1;
+      } else if (kind == "light") {
+        record.kind = material_kind::light;
+        parameter_count = 3;
+      } else {
+        return fail("unknown material kind '" + kind + "'");
+      }
+      if (!numbers(record.params, parameter_count)) return fail("bad parameters for " + kind);
+      material_names.emplace(name, static_cast<uint32_t>(out.materials.size()));
+      out.materials.push_back(record);
+    } else if (keyword == "sphere") {
+      sphere_record record{};
+      if (!numbers(record.center, 3) || !numbers(&record.radius, 1)) return fail("expected: sphere cx cy cz radius <material>");
+      if (!material_ref(record.material)) return false;
+      out.spheres.push_back(record);
+    } else if (keyword == "box") {
+      box_record record{};
+      if (!numbers(record.min_corner, 3) || !numbers(record.max_corner, 3)) return fail("expected: box x0 y0 z0 x1 y1 z1 <material>");
+      if (!material_ref(record.material)) return false;
+      out.boxes.push_back(record);
+    } else if (keyword == "plane") {
+      plane_record record{};
+      if (!numbers(record.point, 3) || !numbers(record.normal, 3)) return fail("expected: plane px py pz nx ny nz <material>");
+      if (!material_ref(record.material)) return false;
+      out.planes.push_back(record);
+    } else if (keyword == "quad") {
+      quad_record record{};
+      if (!numbers(record.corner, 3) || !numbers(record.u, 3) || !numbers(record.v, 3)) {
+        return fail("expected: quad cx cy cz ux uy uz vx vy vz <material>");
+      }
+      if (!material_ref(record.material)) return false;
+      out.quads.push_back(record);
+    } else if (keyword == "mesh") {
+      mesh_record record{};
+      std::string file;
+      if (!(tokens >> file)) return fail("expected: mesh <file> <material>");
+      if (file.size() >= sizeof(record.path)) return fail("mesh path too long");
+      std::memcpy(record.path, file.c_str(), file.size() + 1);
+      if (!material_ref(record.material)) return false;
+      out.meshes.push_back(record);
+    } else if (keyword == "instance") {
+      instance_record record{};
+      std::string file;
+      if (!(tokens >> file)) return fail("expected: instance <file> <material> [transform...]");
+      if (file.size() >= sizeof(record.path)) return fail("mesh path too long");
+      std::memcpy(record.path, file.c_str(), file.size() + 1);
+      if (!material_ref(record.material)) return false;
+
+      affine_transform object_to_world;
+      std::string operation;
+      while (tokens >> operation) {
+        double values[4];
+        if (operation == "translate" && numbers(values, 3)) {
+          object_to_world = affine_transform::translation(vec3(values[0], values[1], values[2])) * object_to_world;
+        } else if (operation == "scale" && numbers(values, 3)) {
+          object_to_world = affine_transform::scaling(vec3(values[0], values[1], values[2])) * object_to_world;
+        } else if (operation == "rotate" && numbers(values, 4)) {
+          object_to_world = affine_transform::rotation(vec3(values[0], values[1], values[2]), values[3]) * object_to_world;
+        } else {
+          return fail("bad transform '" + operation + "'");
+        }
+      }
+      affine_transform unused;
+      if (!object_to_world.invert(unused)) return fail("transform is not invertible");
+      std::memcpy(record.object_to_world, object_to_world.m, sizeof(record.object_to_world));
+      out.instances.push_back(record);
+    } else {
+      return fail("unknown keyword '" + keyword + "'");
+    }
+
+    if (!end_of_line()) return false;
+  }
+
+  return true;
+}
+
+bool scene::write_cache(const std::string& path, const scene_view& view, const source& data,
+                        uint64_t source_size, int64_t source_mtime) {
+  cache_header header{};
+  std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+  header.version = cache_version;
+  header.source_size = source_size;
+  header.source_mtime = source_mtime;
+  header.view = view;
+  header.material_count = data.materials.size();
+  header.sphere_count = data.spheres.size();
+  header.box_count = data.boxes.size();
+  header.plane_count = data.planes.size();
+  header.quad_count = data.quads.size();
+  header.mesh_count = data.meshes.size();
+  header.instance_count = data.instances.size();
+
+  // Written to a temporary name and renamed, so a concurrent run never maps a
+  // half-written file.
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_records(out, data.materials);
+    write_records(out, data.spheres);
+    write_records(out, data.boxes);
+    write_records(out, data.planes);
+    write_records(out, data.quads);
+    write_records(out, data.meshes);
+    write_records(out, data.instances);
+    if (!out) {
+      return false;
+    }
+  }
+  return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+bool scene::load_cache(const std::string& path, const std::string& cache, uint64_t source_size,
+                       int64_t source_mtime, bool& built) {
+  mapped_file file;
+  if (!file.open(cache) || file.size() < sizeof(cache_header)) {
+    return false;
+  }
+
+  cache_header header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version ||
+      header.source_size != source_size || header.source_mtime != source_mtime) {
+    return false;
+  }
+
+  const uint64_t expected = sizeof(cache_header) + header.material_count * sizeof(material_record)
+                          + header.sphere_count * sizeof(sphere_record) + header.box_count * sizeof(box_record)
+                          + header.plane_count * sizeof(plane_record) + header.quad_count * sizeof(quad_record)
+                          + header.mesh_count * sizeof(mesh_record) + header.instance_count * sizeof(instance_record);
+  if (file.size() != expected) {
+    return false;
+  }
+
+  const unsigned char* cursor = file.data() + sizeof(cache_header);
+  auto material_data = take_records<material_record>(cursor, header.material_count);
+  auto sphere_data = take_records<sphere_record>(cursor, header.sphere_count);
+  auto box_data = take_records<box_record>(cursor, header.box_count);
+  auto plane_data = take_records<plane_record>(cursor, header.plane_count);
+  auto quad_data = take_records<quad_record>(cursor, header.quad_count);
+  auto mesh_data = take_records<mesh_record>(cursor, header.mesh_count);
+  auto instance_data = take_records<instance_record>(cursor, header.instance_count);
+
+  // The stamp matching proves the cache is current, not that it is intact: a
+  // damaged file falls back to the source, which rewrites it.
+  bool known_materials = true;
+  for (const material_record& m : material_data) {
+    known_materials = known_materials && m.kind <= material_kind::light;
+  }
+  const size_t material_count = material_data.count;
+  if (!known_materials || !materials_in_range(sphere_data, material_count) ||
+      !materials_in_range(box_data, material_count) || !materials_in_range(plane_data, material_count) ||
+      !materials_in_range(quad_data, material_count) || !materials_in_range(mesh_data, material_count) ||
+      !materials_in_range(instance_data, material_count) || !paths_terminated(mesh_data) ||
+      !paths_terminated(instance_data)) {
+    std::cerr << cache << ": invalid compiled scene, reparsing " << path << std::endl;
+    return false;
+  }
+
+  view = header.view;
+  built = build(path, material_data, sphere_data, box_data, plane_data, quad_data, mesh_data, instance_data);
+  return true;
+}
+
+bool scene::build(const std::string& path, record_span<material_record> material_data,
+                  record_span<sphere_record> sphere_data, record_span<box_record> box_data,
+                  record_span<plane_record> plane_data, record_span<quad_record> quad_data,
+                  record_span<mesh_record> mesh_data, record_span<instance_record> instance_data) {
+  world.clear();
+  lights.clear();
+  materials.clear();
+
+  // Records are zero-initialized when parsed, so padding hashes the same every time.
+  fingerprint = 1469598103934665603ull;
+  auto hash_records = [&](const auto& records) {
+    fingerprint = hash_bytes(fingerprint, &records.count, sizeof(records.count));
+    fingerprint = hash_bytes(fingerprint, records.data, records.count * sizeof(*records.data));
+  };
+  hash_records(material_data);
+  hash_records(sphere_data);
+  hash_records(box_data);
+  hash_records(plane_data);
+  hash_records(quad_data);
+  hash_records(mesh_data);
+  hash_records(instance_data);
+  auto hash_file = [&](const std::string& file) {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    source_stamp(file, size, mtime);
+    fingerprint = hash_bytes(fingerprint, &size, sizeof(size));
+    fingerprint = hash_bytes(fingerprint, &mtime, sizeof(mtime));
+  };
+
+  for (const material_record& m : material_data) {
+    switch (m.kind) {
+      case material_kind::lambertian:
+        materials.emplace<lambertian>(color(m.params[0], m.params[1], m.params[2]));
+        break;
+      case material_kind::metal:
+        materials.emplace<metal>(color(m.params[0], m.params[1], m.params[2]), m.params[3]);
+        break;
+      case material_kind::dielectric:
+        materials.emplace<dielectric>(m.params[0]);
+        break;
+      case material_kind::light:
+        materials.emplace<diffuse_light>(color(m.params[0], m.params[1], m.params[2]));
+        break;
+      default:
+        return false;
+    }
+  }
+
+  auto valid = [&](uint32_t material) { return material < materials.size(); };
+  auto emits = [&](uint32_t material) { return material_data.data[material].kind == material_kind::light; };
+
+  // Nearby spheres share a sphere_set of at most lane_padding (a 64-byte vector of
+  // each coordinate), so the BVH over the sets still culls while each set is tested
+  // several spheres at a time.
+  std::vector<double> radii;
+  for (const sphere_record& s : sphere_data) {
+    if (!valid(s.material)) return false;
+    radii.push_back(s.radius);
+  }
+  double median_radius = 0;
+  if (!radii.empty()) {
+    std::nth_element(radii.begin(), radii.begin() + radii.size() / 2, radii.end());
+    median_radius = radii[radii.size() / 2];
+  }
+
+  std::vector<const sphere_record*> clustered;
+  for (const sphere_record& s : sphere_data) {
+    const point3 center(s.center[0], s.center[1], s.center[2]);
+    if (s.radius > huge_sphere_ratio * median_radius) {
+      auto shape = std::make_shared<sphere>(center, s.radius, s.material);
+      world.add(shape);
+      if (emits(s.material)) {
+        lights.add(shape);
+      }
+      continue;
+    }
+    clustered.push_back(&s);
+    if (emits(s.material)) {
+      lights.add(std::make_shared<sphere>(center, s.radius, s.material));
+    }
+  }
+
+  std::vector<std::pair<size_t, size_t>> clusters;
+  if (!clustered.empty()) {
+    cluster_spheres(clustered, 0, clustered.size(), sphere_set::lane_padding, clusters);
+  }
+  for (const auto& range : clusters) {
+    auto spheres = std::make_shared<sphere_set>();
+    for (size_t k = range.first; k < range.second; ++k) {
+      const sphere_record& s = *clustered[k];
+      spheres->add(point3(s.center[0], s.center[1], s.center[2]), s.radius, s.material);
+    }
+    world.add(spheres);
+  }
+  for (const box_record& b : box_data) {
+    if (!valid(b.material)) return false;
+    auto shape = std::make_shared<box>(point3(b.min_corner[0], b.min_corner[1], b.min_corner[2]),
+                                       point3(b.max_corner[0], b.max_corner[1], b.max_corner[2]), b.material);
+    world.add(shape);
+    if (emits(b.material)) {
+      lights.add(shape);
+    }
+  }
+  for (const plane_record& p : plane_data) {
+    if (!valid(p.material)) return false;
+    world.add(std::make_shared<plane>(point3(p.point[0], p.point[1], p.point[2]),
+                                      vec3(p.normal[0], p.normal[1], p.normal[2]), p.material));
+  }
+  for (const quad_record& q : quad_data) {
+    if (!valid(q.material)) return false;
+    auto shape = std::make_shared<quad>(point3(q.corner[0], q.corner[1], q.corner[2]), vec3(q.u[0], q.u[1], q.u[2]),
+                                        vec3(q.v[0], q.v[1], q.v[2]), q.material);
+    world.add(shape);
+    if (emits(q.material)) {
+      lights.add(shape);
+    }
+  }
+
+  const size_t slash = path.find_last_of('/');
+  const std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+  auto resolve = [&](const char* path_field) {
+    const std::string file(path_field, strnlen(path_field, sizeof(mesh_record::path)));
+    return file[0] == '/' ? file : directory + file;
+  };
+  for (const mesh_record& m : mesh_data) {
+    if (!valid(m.material)) return false;
+    hash_file(resolve(m.path));
+    auto mesh = triangle_mesh::load(resolve(m.path), m.material);
+    if (!mesh) return false;
+    world.add(mesh);
+  }
+
+  // Every instance of a file shares one mesh and supplies its own material.
+  std::unordered_map<std::string, std::shared_ptr<triangle_mesh>> shared_meshes;
+  for (const instance_record& i : instance_data) {
+    if (!valid(i.material)) return false;
+    const std::string file = resolve(i.path);
+    auto& mesh = shared_meshes[file];
+    if (!mesh) {
+      hash_file(file);
+      mesh = triangle_mesh::load(file, no_material);
+      if (!mesh) return false;
+    }
+
+    affine_transform object_to_world;
+    std::memcpy(object_to_world.m, i.object_to_world, sizeof(i.object_to_world));
+    auto placed = instance::create(mesh, object_to_world, i.material);
+    if (!placed) return false;
+    world.add(placed);
+  }
+  return true;
+}
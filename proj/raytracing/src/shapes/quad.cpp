@@ -0,0 +1,77 @@
+#include <cmath>
+
+#include <shapes/quad.hpp>
+
+#include <objects/hit_record.hpp>
+#include <objects/interval.hpp>
+
+#include <render/render_stats.hpp>
+
+#include <constants.hpp>
+#include <randomizer.hpp>
+
+quad::quad(const point3& _corner, const vec3& _u, const vec3& _v, material_id _material)
+    : corner(_corner), u(_u), v(_v), mat(_material) {
+  vec3 n = cross(u, v);
+  normal = unit_vector(n);
+  offset = dot(normal, corner);
+  w = n / dot(n, n);
+  area = n.length();
+}
+
+bool quad::intersect(const ray& r, interval ray_interval, intersection& isect) const {
+  RT_STAT_INC(quad_tests);
+  double denom = dot(normal, r.direction());
+  if (std::fabs(denom) < 1e-8) {
+    return false;
+  }
+
+  double t = (offset - dot(normal, r.origin())) / denom;
+  if (!ray_interval.surrounds(t)) {
+    return false;
+  }
+
+  vec3 planar = r.at(t) - corner;
+  double alpha = dot(w, cross(planar, v));
+  double beta = dot(w, cross(u, planar));
+  if (alpha < 0 || alpha > 1 || beta < 0 || beta > 1) {
+    return false;
+  }
+
+  isect.t = t;
+  isect.object = this;
+  isect.primitive = 0;
+  return true;
+}
+
+void quad::surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const {
+  rec.t = isect.t;
+  rec.p = r.at(rec.t);
+  rec.mat = mat;
+  rec.set_face_normal(r, normal);
+}
+
+aabb quad::bounding_box() const {
+  return aabb(aabb(corner, corner + u + v), aabb(corner + u, corner + v));
+}
+
+vec3 quad::random_direction(const point3& origin) const {
+  // One draw per edge, in a fixed order; two calls in one expression may run in
+  // either order.
+  double r[2];
+  thread_rng().fill(r, 2);
+  return corner + r[0] * u + r[1] * v - origin;
+}
+
+// Area density converted to solid angle: distance^2 / (cos * area)
+double quad::pdf_value(const point3& origin, const vec3& direction) const {
+  intersection isect;
+  if (!intersect(ray(origin, direction), interval(0.001, INF), isect)) {
+    return 0.0;
+  }
+
+  double length = direction.length();
+  double distance = isect.t * length;
+  double cosine = std::fabs(dot(direction, normal)) / length;
+  return distance * distance / (cosine * area);
+}
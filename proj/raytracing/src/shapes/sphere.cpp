@@ -5,23 +5,32 @@
 #include <objects/color.hpp>
 #include <objects/interval.hpp>
 #include <objects/hit_record.hpp>
+#include <objects/onb.hpp>
+#include <objects/sampling.hpp>
 #include <objects/vec3.hpp>
 
-bool sphere::hit(const ray& r, interval ray_interval, hit_record& rec) const {
+#include <render/render_stats.hpp>
+
+#include <constants.hpp>
+#include <randomizer.hpp>
+#include <simd.hpp>
+
+bool sphere::intersect(const ray& r, interval ray_interval, intersection& isect) const {
+  RT_STAT_INC(sphere_tests);
   vec3 oc = r.origin() - center;
-  double a = r.direction().length_squared();
-  double half_b = dot(oc, r.direction());
-  double c = oc.length_squared() - radius * radius;
-  double discriminant = half_b * half_b - a * c;
+  real a = r.direction().length_squared();
+  real half_b = dot(oc, r.direction());
+  real c = oc.length_squared() - radius * radius;
+  real discriminant = half_b * half_b - a * c;
 
   if (discriminant < 0) {
     return false;
   }
 
-  double sqrt_discriminant = std::sqrt(discriminant);
+  real sqrt_discriminant = std::sqrt(discriminant);
 
   // Find the nearest root within the acceptable range.
-  double root = (-half_b - sqrt_discriminant) / a;
+  real root = (-half_b - sqrt_discriminant) / a;
   if (!ray_interval.surrounds(root)) {
     root = (-half_b + sqrt_discriminant) / a;
     if (!ray_interval.surrounds(root)) {
@@ -29,11 +38,128 @@ bool sphere::hit(const ray& r, interval ray_interval, hit_record& rec) const {
     }
   }
 
-  rec.t = root;
+  isect.t = root;
+  isect.object = this;
+  isect.primitive = 0;
+
+  return true;
+}
+
+void sphere::surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const {
+  rec.t = isect.t;
   rec.p = r.at(rec.t);
   vec3 outward_normal = (rec.p - center) / radius;
   rec.set_face_normal(r, outward_normal);
   rec.mat = mat;
+}
 
-  return true;
+aabb sphere::bounding_box() const {
+  vec3 extent(radius, radius, radius);
+  return aabb(center - extent, center + extent);
+}
+
+// Either root inside the interval blocks the ray; no need to find the nearer one.
+bool sphere::occluded(const ray& r, interval ray_interval) const {
+  RT_STAT_INC(sphere_tests);
+  vec3 oc = r.origin() - center;
+  real a = r.direction().length_squared();
+  real half_b = dot(oc, r.direction());
+  real c = oc.length_squared() - radius * radius;
+  real discriminant = half_b * half_b - a * c;
+  if (discriminant < 0) {
+    return false;
+  }
+
+  real sqrt_discriminant = std::sqrt(discriminant);
+  return ray_interval.surrounds((-half_b - sqrt_discriminant) / a)
+      || ray_interval.surrounds((-half_b + sqrt_discriminant) / a);
+}
+
+vec3 sphere::random_direction(const point3& origin) const {
+  vec3 to_center = center - origin;
+  double distance_squared = to_center.length_squared();
+  if (distance_squared <= radius * radius) {
+    return vec3(1, 0, 0);
+  }
+
+  // Uniform over the solid angle of the cone the sphere subtends
+  double cos_theta_max = std::sqrt(1 - radius * radius / distance_squared);
+  double u[2];
+  thread_rng().fill(u, 2);
+  return onb(to_center).transform(sample_uniform_cone(u[0], u[1], cos_theta_max).value);
+}
+
+double sphere::pdf_value(const point3& origin, const vec3& direction) const {
+  double distance_squared = (center - origin).length_squared();
+  intersection isect;
+  if (distance_squared <= radius * radius || !intersect(ray(origin, direction), interval(0.001, INF), isect)) {
+    return 0.0;
+  }
+
+  return uniform_cone_pdf(std::sqrt(1 - radius * radius / distance_squared));
+}
+
+uint32_t sphere::hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const {
+  RT_STAT_ADD(sphere_tests, __builtin_popcount(active));
+  const simd::vd cx = simd::set1(center.x());
+  const simd::vd cy = simd::set1(center.y());
+  const simd::vd cz = simd::set1(center.z());
+  const simd::vd radius_sq = simd::set1(radius * radius);
+  const simd::vd t_min = simd::set1(packet.t_min);
+  const simd::vd zero = simd::set1(0);
+  const uint32_t chunk_mask = (1u << simd::width) - 1;
+
+  uint32_t hits = 0;
+  for (int base = 0; base < ray_packet::size; base += simd::width) {
+    uint32_t chunk_active = (active >> base) & chunk_mask;
+    if (chunk_active == 0) continue;
+
+    simd::vd ocx = simd::sub(simd::load(&packet.origin_x[base]), cx);
+    simd::vd ocy = simd::sub(simd::load(&packet.origin_y[base]), cy);
+    simd::vd ocz = simd::sub(simd::load(&packet.origin_z[base]), cz);
+    simd::vd dx = simd::load(&packet.direction_x[base]);
+    simd::vd dy = simd::load(&packet.direction_y[base]);
+    simd::vd dz = simd::load(&packet.direction_z[base]);
+    simd::vd t_max = simd::load(&packet.t_max[base]);
+
+    simd::vd a = simd::add(simd::add(simd::mul(dx, dx), simd::mul(dy, dy)), simd::mul(dz, dz));
+    simd::vd half_b = simd::add(simd::add(simd::mul(ocx, dx), simd::mul(ocy, dy)), simd::mul(ocz, dz));
+    simd::vd oc_len_sq = simd::add(simd::add(simd::mul(ocx, ocx), simd::mul(ocy, ocy)), simd::mul(ocz, ocz));
+    simd::vd c = simd::sub(oc_len_sq, radius_sq);
+    simd::vd discriminant = simd::sub(simd::mul(half_b, half_b), simd::mul(a, c));
+
+    simd::mask has_roots = simd::ge(discriminant, zero);
+    if (simd::bits(has_roots) == 0) continue;
+
+    // Divide once per lane instead of twice; a is never zero for a valid ray.
+    alignas(64) real a_lanes[simd::width];
+    simd::store(a_lanes, a);
+    for (int k = 0; k < simd::width; ++k) a_lanes[k] = 1 / a_lanes[k];
+    simd::vd inv_a = simd::load(a_lanes);
+
+    simd::vd sqrt_discriminant = simd::sqrt(simd::max(discriminant, zero));
+    simd::vd neg_half_b = simd::sub(zero, half_b);
+    simd::vd near_root = simd::mul(simd::sub(neg_half_b, sqrt_discriminant), inv_a);
+    simd::vd far_root = simd::mul(simd::add(neg_half_b, sqrt_discriminant), inv_a);
+    simd::mask near_ok = simd::both(simd::gt(near_root, t_min), simd::lt(near_root, t_max));
+    simd::mask far_ok = simd::both(simd::gt(far_root, t_min), simd::lt(far_root, t_max));
+
+    uint32_t chunk_hits = static_cast<uint32_t>(simd::bits(simd::both(has_roots, simd::either(near_ok, far_ok)))) & chunk_active;
+    if (chunk_hits == 0) continue;
+
+    alignas(64) real roots[simd::width];
+    simd::store(roots, simd::select(near_ok, near_root, far_root));
+
+    for (int k = 0; k < simd::width; ++k) {
+      if (!(chunk_hits & (1u << k))) continue;
+      int lane = base + k;
+      isects[lane].t = roots[k];
+      isects[lane].object = this;
+      isects[lane].primitive = 0;
+      packet.t_max[lane] = roots[k];
+    }
+    hits |= chunk_hits << base;
+  }
+
+  return hits;
 }
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <shapes/sphere_set.hpp>
+
+#include <objects/hit_record.hpp>
+#include <objects/interval.hpp>
+#include <objects/ray_packet.hpp>
+#include <objects/vec3.hpp>
+
+#include <render/render_stats.hpp>
+
+#include <simd.hpp>
+
+static_assert(sphere_set::lane_padding % simd::width == 0, "padding must cover a whole SIMD vector");
+
+// sphere_set method definitions
+void sphere_set::add(const point3& center, double r, material_id mat) {
+  if (count == radius.size()) {
+    // Padding lanes get a NaN radius, which makes their discriminant NaN and
+    // therefore never a hit, so the kernel needs no tail handling.
+    const real nan = std::numeric_limits<real>::quiet_NaN();
+    center_x.resize(count + lane_padding, 0);
+    center_y.resize(count + lane_padding, 0);
+    center_z.resize(count + lane_padding, 0);
+    radius.resize(count + lane_padding, nan);
+    material_index.resize(count + lane_padding, no_material);
+  }
+
+  r = std::max(0.0, r);
+  center_x[count] = center.x();
+  center_y[count] = center.y();
+  center_z[count] = center.z();
+  radius[count] = r;
+  material_index[count] = mat;
+  ++count;
+
+  vec3 extent(r, r, r);
+  bbox = aabb(bbox, aabb(center - extent, center + extent));
+}
+
+size_t sphere_set::size() const {
+  return count;
+}
+
+int sphere_set::simd_width() {
+  return simd::width;
+}
+
+bool sphere_set::intersect(const ray& r, interval ray_interval, intersection& isect) const {
+  if (count == 0) {
+    return false;
+  }
+  RT_STAT_ADD(sphere_tests, count);
+
+  const point3& origin = r.origin();
+  const vec3& direction = r.direction();
+  const real a_scalar = direction.length_squared();
+
+  const simd::vd ox = simd::set1(origin.x());
+  const simd::vd oy = simd::set1(origin.y());
+  const simd::vd oz = simd::set1(origin.z());
+  const simd::vd dx = simd::set1(direction.x());
+  const simd::vd dy = simd::set1(direction.y());
+  const simd::vd dz = simd::set1(direction.z());
+  const simd::vd a = simd::set1(a_scalar);
+  const simd::vd inv_a = simd::set1(1 / a_scalar);
+  const simd::vd t_min = simd::set1(ray_interval.min);
+  const simd::vd zero = simd::set1(0);
+  const simd::vd step = simd::set1(simd::width);
+
+  // Each lane keeps its own closest distance and sphere index; they are reduced
+  // to a single winner once after the loop.
+  simd::vd best_t = simd::set1(ray_interval.max);
+  simd::vd best_index = simd::set1(-1);
+  simd::vd index = simd::lane_index();
+
+  for (size_t i = 0; i < count; i += simd::width) {
+    simd::vd ocx = simd::sub(ox, simd::load(&center_x[i]));
+    simd::vd ocy = simd::sub(oy, simd::load(&center_y[i]));
+    simd::vd ocz = simd::sub(oz, simd::load(&center_z[i]));
+    simd::vd rad = simd::load(&radius[i]);
+
+    simd::vd half_b = simd::add(simd::add(simd::mul(ocx, dx), simd::mul(ocy, dy)), simd::mul(ocz, dz));
+    simd::vd oc_len_sq = simd::add(simd::add(simd::mul(ocx, ocx), simd::mul(ocy, ocy)), simd::mul(ocz, ocz));
+    simd::vd c = simd::sub(oc_len_sq, simd::mul(rad, rad));
+    simd::vd discriminant = simd::sub(simd::mul(half_b, half_b), simd::mul(a, c));
+
+    simd::mask has_roots = simd::ge(discriminant, zero);
+    simd::vd sqrt_discriminant = simd::sqrt(simd::max(discriminant, zero));
+    simd::vd neg_half_b = simd::sub(zero, half_b);
+
+    // Same root selection as sphere::hit: nearest root first, then the far one.
+    simd::vd near_root = simd::mul(simd::sub(neg_half_b, sqrt_discriminant), inv_a);
+    simd::vd far_root = simd::mul(simd::add(neg_half_b, sqrt_discriminant), inv_a);
+    simd::mask near_ok = simd::both(simd::gt(near_root, t_min), simd::lt(near_root, best_t));
+    simd::mask far_ok = simd::both(simd::gt(far_root, t_min), simd::lt(far_root, best_t));
+
+    simd::mask hit_mask = simd::both(has_roots, simd::either(near_ok, far_ok));
+    simd::vd root = simd::select(near_ok, near_root, far_root);
+
+    best_t = simd::select(hit_mask, root, best_t);
+    best_index = simd::select(hit_mask, index, best_index);
+    index = simd::add(index, step);
+  }
+
+  alignas(64) real lane_t[simd::width];
+  alignas(64) real lane_index[simd::width];
+  simd::store(lane_t, best_t);
+  simd::store(lane_index, best_index);
+
+  int winner = -1;
+  real closest = ray_interval.max;
+  for (int lane = 0; lane < simd::width; ++lane) {
+    if (lane_index[lane] >= 0 && lane_t[lane] < closest) {
+      closest = lane_t[lane];
+      winner = static_cast<int>(lane_index[lane]);
+    }
+  }
+  if (winner < 0) {
+    return false;
+  }
+
+  isect.t = closest;
+  isect.object = this;
+  isect.primitive = static_cast<uint32_t>(winner);
+
+  return true;
+}
+
+void sphere_set::surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const {
+  const uint32_t k = isect.primitive;
+  const point3 center(center_x[k], center_y[k], center_z[k]);
+  rec.t = isect.t;
+  rec.p = r.at(rec.t);
+  vec3 outward_normal = (rec.p - center) / radius[k];
+  rec.set_face_normal(r, outward_normal);
+  rec.mat = material_index[k];
+}
+
+uint32_t sphere_set::hit_packet(ray_packet& packet, uint32_t active, intersection* isects) const {
+  if (count == 0) {
+    return 0;
+  }
+  RT_STAT_ADD(sphere_tests, __builtin_popcount(active) * count);
+  const simd::vd t_min = simd::set1(packet.t_min);
+  const simd::vd zero = simd::set1(0);
+  const uint32_t chunk_mask = (1u << simd::width) - 1;
+
+  uint32_t hits = 0;
+  for (int base = 0; base < ray_packet::size; base += simd::width) {
+    uint32_t chunk_active = (active >> base) & chunk_mask;
+    if (chunk_active == 0) continue;
+
+    const simd::vd ox = simd::load(&packet.origin_x[base]);
+    const simd::vd oy = simd::load(&packet.origin_y[base]);
+    const simd::vd oz = simd::load(&packet.origin_z[base]);
+    const simd::vd dx = simd::load(&packet.direction_x[base]);
+    const simd::vd dy = simd::load(&packet.direction_y[base]);
+    const simd::vd dz = simd::load(&packet.direction_z[base]);
+    const simd::vd a = simd::add(simd::add(simd::mul(dx, dx), simd::mul(dy, dy)), simd::mul(dz, dz));
+
+    // Divide once per lane, as intersect() does; lanes without a ray are masked out below.
+    alignas(64) real a_lanes[simd::width];
+    simd::store(a_lanes, a);
+    for (int k = 0; k < simd::width; ++k) a_lanes[k] = 1 / a_lanes[k];
+    const simd::vd inv_a = simd::load(a_lanes);
+
+    simd::vd best_t = simd::load(&packet.t_max[base]);
+    simd::vd best_index = simd::set1(-1);
+
+    for (size_t i = 0; i < count; ++i) {
+      simd::vd ocx = simd::sub(ox, simd::set1(center_x[i]));
+      simd::vd ocy = simd::sub(oy, simd::set1(center_y[i]));
+      simd::vd ocz = simd::sub(oz, simd::set1(center_z[i]));
+
+      simd::vd half_b = simd::add(simd::add(simd::mul(ocx, dx), simd::mul(ocy, dy)), simd::mul(ocz, dz));
+      simd::vd oc_len_sq = simd::add(simd::add(simd::mul(ocx, ocx), simd::mul(ocy, ocy)), simd::mul(ocz, ocz));
+      simd::vd rad = simd::set1(radius[i]);
+      simd::vd c = simd::sub(oc_len_sq, simd::mul(rad, rad));
+      simd::vd discriminant = simd::sub(simd::mul(half_b, half_b), simd::mul(a, c));
+
+      simd::mask has_roots = simd::ge(discriminant, zero);
+      if (simd::bits(has_roots) == 0) continue;
+      simd::vd sqrt_discriminant = simd::sqrt(simd::max(discriminant, zero));
+      simd::vd neg_half_b = simd::sub(zero, half_b);
+      simd::vd near_root = simd::mul(simd::sub(neg_half_b, sqrt_discriminant), inv_a);
+      simd::vd far_root = simd::mul(simd::add(neg_half_b, sqrt_discriminant), inv_a);
+      simd::mask near_ok = simd::both(simd::gt(near_root, t_min), simd::lt(near_root, best_t));
+      simd::mask far_ok = simd::both(simd::gt(far_root, t_min), simd::lt(far_root, best_t));
+
+      simd::mask hit_mask = simd::both(has_roots, simd::either(near_ok, far_ok));
+      best_t = simd::select(hit_mask, simd::select(near_ok, near_root, far_root), best_t);
+      best_index = simd::select(hit_mask, simd::set1(static_cast<real>(i)), best_index);
+    }
+
+    alignas(64) real lane_t[simd::width];
+    alignas(64) real lane_index[simd::width];
+    simd::store(lane_t, best_t);
+    simd::store(lane_index, best_index);
+
+    uint32_t chunk_hits = 0;
+    for (int k = 0; k < simd::width; ++k) {
+      if (!(chunk_active & (1u << k)) || lane_index[k] < 0) continue;
+      int lane = base + k;
+      isects[lane].t = lane_t[k];
+      isects[lane].object = this;
+      isects[lane].primitive = static_cast<uint32_t>(lane_index[k]);
+      packet.t_max[lane] = lane_t[k];
+      chunk_hits |= 1u << k;
+    }
+    hits |= chunk_hits << base;
+  }
+
+  return hits;
+}
+
+bool sphere_set::occluded(const ray& r, interval ray_interval) const {
+  if (count == 0) {
+    return false;
+  }
+
+  const point3& origin = r.origin();
+  const vec3& direction = r.direction();
+  const real a_scalar = direction.length_squared();
+
+  const simd::vd ox = simd::set1(origin.x());
+  const simd::vd oy = simd::set1(origin.y());
+  const simd::vd oz = simd::set1(origin.z());
+  const simd::vd dx = simd::set1(direction.x());
+  const simd::vd dy = simd::set1(direction.y());
+  const simd::vd dz = simd::set1(direction.z());
+  const simd::vd a = simd::set1(a_scalar);
+  const simd::vd inv_a = simd::set1(1 / a_scalar);
+  const simd::vd t_min = simd::set1(ray_interval.min);
+  const simd::vd t_max = simd::set1(ray_interval.max);
+  const simd::vd zero = simd::set1(0);
+
+  for (size_t i = 0; i < count; i += simd::width) {
+    RT_STAT_ADD(sphere_tests, std::min<size_t>(simd::width, count - i));
+    simd::vd ocx = simd::sub(ox, simd::load(&center_x[i]));
+    simd::vd ocy = simd::sub(oy, simd::load(&center_y[i]));
+    simd::vd ocz = simd::sub(oz, simd::load(&center_z[i]));
+    simd::vd rad = simd::load(&radius[i]);
+
+    simd::vd half_b = simd::add(simd::add(simd::mul(ocx, dx), simd::mul(ocy, dy)), simd::mul(ocz, dz));
+    simd::vd oc_len_sq = simd::add(simd::add(simd::mul(ocx, ocx), simd::mul(ocy, ocy)), simd::mul(ocz, ocz));
+    simd::vd c = simd::sub(oc_len_sq, simd::mul(rad, rad));
+    simd::vd discriminant = simd::sub(simd::mul(half_b, half_b), simd::mul(a, c));
+
+    simd::mask has_roots = simd::ge(discriminant, zero);
+    if (simd::bits(has_roots) == 0) continue;
+    simd::vd sqrt_discriminant = simd::sqrt(simd::max(discriminant, zero));
+    simd::vd neg_half_b = simd::sub(zero, half_b);
+    simd::vd near_root = simd::mul(simd::sub(neg_half_b, sqrt_discriminant), inv_a);
+    simd::vd far_root = simd::mul(simd::add(neg_half_b, sqrt_discriminant), inv_a);
+    simd::mask near_ok = simd::both(simd::gt(near_root, t_min), simd::lt(near_root, t_max));
+    simd::mask far_ok = simd::both(simd::gt(far_root, t_min), simd::lt(far_root, t_max));
+    if (simd::bits(simd::both(has_roots, simd::either(near_ok, far_ok))) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+aabb sphere_set::bounding_box() const {
+  return bbox;
+}
@@ -0,0 +1,159 @@
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include <shapes/triangle_mesh.hpp>
+
+#include <io/mesh_loader.hpp>
+
+#include <render/render_stats.hpp>
+#include <render/timeline.hpp>
+
+namespace {
+
+// Per-ray setup of the watertight test: the axis where the direction is largest
+// becomes z, and the shear maps the direction onto (0, 0, 1).
+struct watertight_ray {
+  int kx, ky, kz;
+  double sx, sy, sz;
+  point3 origin;
+
+  explicit watertight_ray(const ray& r): origin(r.origin()) {
+    const vec3& d = r.direction();
+    kz = 0;
+    if (std::fabs(d.y()) > std::fabs(d[kz])) kz = 1;
+    if (std::fabs(d.z()) > std::fabs(d[kz])) kz = 2;
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+    // Keep the winding of the frame so front faces stay front faces.
+    if (d[kz] < 0) std::swap(kx, ky);
+
+    sx = d[kx] / d[kz];
+    sy = d[ky] / d[kz];
+    sz = 1.0 / d[kz];
+  }
+
+  // Distance to triangle (a, b, c), or false if it is missed or outside ray_interval.
+  bool hit(const point3& a, const point3& b, const point3& c, const interval& ray_interval, double& t) const {
+    const vec3 pa = a - origin;
+    const vec3 pb = b - origin;
+    const vec3 pc = c - origin;
+
+    const double ax = pa[kx] - sx * pa[kz];
+    const double ay = pa[ky] - sy * pa[kz];
+    const double bx = pb[kx] - sx * pb[kz];
+    const double by = pb[ky] - sy * pb[kz];
+    const double cx = pc[kx] - sx * pc[kz];
+    const double cy = pc[ky] - sy * pc[kz];
+
+    // Scaled barycentrics: 2D edge functions in the sheared frame.
+    const double u = cx * by - cy * bx;
+    const double v = ax * cy - ay * cx;
+    const double w = bx * ay - by * ax;
+    if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0)) {
+      return false;
+    }
+
+    const double det = u + v + w;
+    if (det == 0) {
+      return false;
+    }
+
+    const double az = sz * pa[kz];
+    const double bz = sz * pb[kz];
+    const double cz = sz * pc[kz];
+    const double scaled_t = u * az + v * bz + w * cz;
+
+    // Compare before dividing; the sign of det tells which way the inequality goes.
+    if (det > 0 ? (scaled_t <= ray_interval.min * det || scaled_t >= ray_interval.max * det)
+                : (scaled_t >= ray_interval.min * det || scaled_t <= ray_interval.max * det)) {
+      return false;
+    }
+    t = scaled_t / det;
+    return true;
+  }
+};
+
+}
+
+// triangle_mesh method definitions
+triangle_mesh::triangle_mesh(std::vector<point3> _vertices, std::vector<uint32_t> _indices, material_id _mat)
+  : vertices(std::move(_vertices)), mat(_mat) {
+  const size_t count = _indices.size() / 3;
+  std::vector<aabb> boxes;
+  boxes.reserve(count);
+  for (size_t k = 0; k < count; ++k) {
+    const point3& a = vertices[_indices[3 * k]];
+    const point3& b = vertices[_indices[3 * k + 1]];
+    const point3& c = vertices[_indices[3 * k + 2]];
+    boxes.push_back(aabb(aabb(a, b), aabb(c, c)));
+  }
+
+  tree.build(boxes);
+
+  // Store triangles in leaf order so a leaf reads one contiguous run of indices.
+  indices.resize(count * 3);
+  for (size_t slot = 0; slot < count; ++slot) {
+    const uint32_t k = tree.indices[slot];
+    indices[3 * slot] = _indices[3 * k];
+    indices[3 * slot + 1] = _indices[3 * k + 1];
+    indices[3 * slot + 2] = _indices[3 * k + 2];
+  }
+}
+
+std::shared_ptr<triangle_mesh> triangle_mesh::load(const std::string& path, material_id mat) {
+  trace_span span("load mesh", "scene");
+  std::vector<point3> vertices;
+  std::vector<uint32_t> indices;
+  if (!load_mesh(path, vertices, indices)) {
+    return nullptr;
+  }
+  return std::make_shared<triangle_mesh>(std::move(vertices), std::move(indices), mat);
+}
+
+bool triangle_mesh::intersect(const ray& r, interval ray_interval, intersection& isect) const {
+  const watertight_ray test(r);
+  return tree.traverse(r, ray_interval, [&](uint32_t slot, interval& current) {
+    RT_STAT_INC(triangle_tests);
+    double t;
+    if (!test.hit(vertices[indices[3 * slot]], vertices[indices[3 * slot + 1]], vertices[indices[3 * slot + 2]],
+                  current, t)) {
+      return false;
+    }
+    current.max = t;
+    isect.t = t;
+    isect.object = this;
+    isect.primitive = slot;
+    return true;
+  });
+}
+
+bool triangle_mesh::occluded(const ray& r, interval ray_interval) const {
+  const watertight_ray test(r);
+  return tree.traverse_any(r, ray_interval, [&](uint32_t slot, const interval& current) {
+    RT_STAT_INC(triangle_tests);
+    double t;
+    return test.hit(vertices[indices[3 * slot]], vertices[indices[3 * slot + 1]], vertices[indices[3 * slot + 2]],
+                    current, t);
+  });
+}
+
+void triangle_mesh::surface_interaction(const ray& r, const intersection& isect, hit_record& rec) const {
+  const uint32_t* tri = &indices[3 * isect.primitive];
+  const point3& a = vertices[tri[0]];
+  const point3& b = vertices[tri[1]];
+  const point3& c = vertices[tri[2]];
+
+  rec.t = isect.t;
+  rec.p = r.at(rec.t);
+  rec.set_face_normal(r, unit_vector(cross(b - a, c - a)));
+  rec.mat = mat;
+}
+
+aabb triangle_mesh::bounding_box() const {
+  return tree.bounds();
+}
+
+size_t triangle_mesh::triangle_count() const {
+  return indices.size() / 3;
+}
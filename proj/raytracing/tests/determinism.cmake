@@ -0,0 +1,64 @@
+# Renders a small scene in ways that must not change a single bit of the image
+# and compares the outputs byte for byte: thread counts, tile sizes, the two
+# integrators, primary ray packets, and a frame split into three --tiles parts
+# and combined with merge.
+#
+# Usage: cmake -DRAYTRACING=<exe> -DMERGE=<exe> -DSCENE=<file> -DWORK_DIR=<dir>
+#              -P determinism.cmake
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+# Render a copy, so the compiled scene cache lands in the work directory
+get_filename_component(scene_name ${SCENE} NAME)
+file(COPY ${SCENE} DESTINATION ${WORK_DIR})
+set(scene ${WORK_DIR}/${scene_name})
+
+# Few samples and bounces keep the test quick
+set(common --width 40 --spp 6 --depth 5 --threads 1)
+
+function(run name)
+  execute_process(COMMAND ${ARGN} WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE result OUTPUT_QUIET
+                  ERROR_VARIABLE error)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${name} failed (${result}):\n${error}")
+  endif()
+endfunction()
+
+function(render name)
+  run(${name} ${RAYTRACING} ${scene} ${common} ${ARGN} --output ${WORK_DIR}/${name}.pfm)
+endfunction()
+
+function(expect_same reference name)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/${reference}.pfm ${WORK_DIR}/${name}.pfm
+                  RESULT_VARIABLE different)
+  if(different)
+    message(FATAL_ERROR "${name}.pfm differs from ${reference}.pfm")
+  endif()
+  message(STATUS "${name} matches ${reference}")
+endfunction()
+
+# Independent and Sobol samples take different paths through the sampler
+foreach(sampler independent sobol)
+  render(${sampler} --sampler ${sampler})
+
+  render(${sampler}_threads --sampler ${sampler} --threads 3)
+  expect_same(${sampler} ${sampler}_threads)
+
+  render(${sampler}_tiles --sampler ${sampler} --tile-size 7)
+  expect_same(${sampler} ${sampler}_tiles)
+
+  render(${sampler}_wavefront --sampler ${sampler} --integrator wavefront)
+  expect_same(${sampler} ${sampler}_wavefront)
+
+  render(${sampler}_packets --sampler ${sampler} --packets on)
+  expect_same(${sampler} ${sampler}_packets)
+
+  set(parts)
+  foreach(part 0 1 2)
+    run(${sampler}_part${part} ${RAYTRACING} ${scene} ${common} --sampler ${sampler} --tiles ${part}/3
+        --partial ${WORK_DIR}/${sampler}_part${part}.rtck)
+    list(APPEND parts ${WORK_DIR}/${sampler}_part${part}.rtck)
+  endforeach()
+  run(${sampler}_merged ${MERGE} ${WORK_DIR}/${sampler}_merged.pfm ${parts})
+  expect_same(${sampler} ${sampler}_merged)
+endforeach()